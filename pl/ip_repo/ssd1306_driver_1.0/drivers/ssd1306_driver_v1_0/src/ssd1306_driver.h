@@ -11,6 +11,22 @@
 #define SSD1306_DRIVER_S00_AXI_SLV_REG1_OFFSET 4
 #define SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET 8
 #define SSD1306_DRIVER_S00_AXI_SLV_REG3_OFFSET 12
+#define SSD1306_DRIVER_S00_AXI_SLV_REG4_OFFSET 16
+#define SSD1306_DRIVER_S00_AXI_SLV_REG5_OFFSET 20
+#define SSD1306_DRIVER_S00_AXI_SLV_REG6_OFFSET 24
+#define SSD1306_DRIVER_S00_AXI_SLV_REG7_OFFSET 28
+#define SSD1306_DRIVER_S00_AXI_SLV_REG8_OFFSET 32
+#define SSD1306_DRIVER_S00_AXI_SLV_REG9_OFFSET 36
+#define SSD1306_DRIVER_S00_AXI_SLV_REG10_OFFSET 40
+#define SSD1306_DRIVER_S00_AXI_SLV_REG11_OFFSET 44
+#define SSD1306_DRIVER_S00_AXI_SLV_REG12_OFFSET 48
+#define SSD1306_DRIVER_S00_AXI_SLV_REG13_OFFSET 52
+#define SSD1306_DRIVER_S00_AXI_SLV_REG14_OFFSET 56
+#define SSD1306_DRIVER_S00_AXI_SLV_REG15_OFFSET 60
+#define SSD1306_DRIVER_S00_AXI_SLV_REG16_OFFSET 64
+#define SSD1306_DRIVER_S00_AXI_SLV_REG17_OFFSET 68
+#define SSD1306_DRIVER_S00_AXI_SLV_REG18_OFFSET 72
+#define SSD1306_DRIVER_S00_AXI_SLV_REG19_OFFSET 76
 
 
 /**************************** Type Definitions *****************************/
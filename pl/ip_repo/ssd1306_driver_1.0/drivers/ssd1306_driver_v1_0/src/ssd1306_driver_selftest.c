@@ -8,6 +8,23 @@
 /************************** Constant Definitions ***************************/
 #define READ_WRITE_MUL_FACTOR 0x10
 
+/* Writing these to slv_reg10 snapshots/clears the performance counters. */
+#define PERF_SNAPSHOT 0x1
+#define PERF_CLEAR 0x2
+#define PERF_COUNTERS_NB 7
+
+/* Register reads to let the counters run for a while. */
+#define PERF_WAIT_READS_NB 1000
+
+/* The registers that read back what was written to them. */
+static const unsigned rw_reg_offsets[] = {
+	SSD1306_DRIVER_S00_AXI_SLV_REG1_OFFSET,
+	SSD1306_DRIVER_S00_AXI_SLV_REG3_OFFSET,
+	SSD1306_DRIVER_S00_AXI_SLV_REG6_OFFSET,
+	SSD1306_DRIVER_S00_AXI_SLV_REG8_OFFSET,
+};
+#define RW_REGS_NB ((int)(sizeof(rw_reg_offsets) / sizeof(rw_reg_offsets[0])))
+
 /************************** Function Definitions ***************************/
 /**
  *
@@ -26,6 +43,7 @@
  *
  * @note    Caching must be turned off for this function to work.
  * @note    Self test may fail if data memory and device are not on the same bus.
+ * @note    The display must be powered off, it gets powered on and off again.
  *
  */
 XStatus SSD1306_DRIVER_Reg_SelfTest(void * baseaddr_p)
@@ -34,6 +52,7 @@ XStatus SSD1306_DRIVER_Reg_SelfTest(void * baseaddr_p)
 	int write_loop_index;
 	int read_loop_index;
 	int Index;
+	u32 rom_cycles;
 
 	baseaddr = (u32) baseaddr_p;
 
@@ -42,19 +61,70 @@ XStatus SSD1306_DRIVER_Reg_SelfTest(void * baseaddr_p)
 	xil_printf("******************************\n\n\r");
 
 	/*
-	 * Write to user logic slave module register(s) and read back
+	 * Write to user logic slave module register(s) and read back, the ones
+	 * that only hold what was written to them, with the display powered off.
 	 */
 	xil_printf("User logic slave module test...\n\r");
 
-	for (write_loop_index = 0 ; write_loop_index < 4; write_loop_index++)
-	  SSD1306_DRIVER_mWriteReg (baseaddr, write_loop_index*4, (write_loop_index+1)*READ_WRITE_MUL_FACTOR);
-	for (read_loop_index = 0 ; read_loop_index < 4; read_loop_index++)
-	  if ( SSD1306_DRIVER_mReadReg (baseaddr, read_loop_index*4) != (read_loop_index+1)*READ_WRITE_MUL_FACTOR){
-	    xil_printf ("Error reading register value at address %x\n", (int)baseaddr + read_loop_index*4);
+	for (write_loop_index = 0 ; write_loop_index < RW_REGS_NB; write_loop_index++)
+	  SSD1306_DRIVER_mWriteReg (baseaddr, rw_reg_offsets[write_loop_index], (write_loop_index+1)*READ_WRITE_MUL_FACTOR);
+	for (read_loop_index = 0 ; read_loop_index < RW_REGS_NB; read_loop_index++)
+	  if ( SSD1306_DRIVER_mReadReg (baseaddr, rw_reg_offsets[read_loop_index]) != (read_loop_index+1)*READ_WRITE_MUL_FACTOR){
+	    xil_printf ("Error reading register value at address %x\n", (int)baseaddr + rw_reg_offsets[read_loop_index]);
 	    return XST_FAILURE;
 	  }
+	for (write_loop_index = 0 ; write_loop_index < RW_REGS_NB; write_loop_index++)
+	  SSD1306_DRIVER_mWriteReg (baseaddr, rw_reg_offsets[write_loop_index], 0);
 
 	xil_printf("   - slave register write/read passed\n\n\r");
 
+	/*
+	 * The performance counters (slv_reg11-17) do not count while the display
+	 * is powered off, a clear and a snapshot must read back as 0.
+	 */
+	xil_printf("Performance counters test...\n\r");
+
+	SSD1306_DRIVER_mWriteReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG10_OFFSET, PERF_CLEAR);
+	SSD1306_DRIVER_mWriteReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG10_OFFSET, PERF_SNAPSHOT);
+	for (read_loop_index = 0 ; read_loop_index < PERF_COUNTERS_NB; read_loop_index++)
+	  if ( SSD1306_DRIVER_mReadReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG11_OFFSET + read_loop_index*4) != 0){
+	    xil_printf ("Error reading cleared counter at address %x\n", (int)baseaddr + SSD1306_DRIVER_S00_AXI_SLV_REG11_OFFSET + read_loop_index*4);
+	    return XST_FAILURE;
+	  }
+
+	/*
+	 * Powering on runs the ROM, which takes ~400ms. Its cycles are counted
+	 * all along, a snapshot holds until the next one.
+	 */
+	SSD1306_DRIVER_mWriteReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET, 1);
+	for (Index = 0; Index < PERF_WAIT_READS_NB; Index++)
+	  SSD1306_DRIVER_mReadReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET);
+	SSD1306_DRIVER_mWriteReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG10_OFFSET, PERF_SNAPSHOT);
+	rom_cycles = SSD1306_DRIVER_mReadReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG16_OFFSET);
+	for (Index = 0; Index < PERF_WAIT_READS_NB; Index++)
+	  SSD1306_DRIVER_mReadReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET);
+	if (rom_cycles == 0 ||
+	    SSD1306_DRIVER_mReadReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG16_OFFSET) != rom_cycles){
+	  xil_printf ("Error taking a snapshot of the ROM cycles\n");
+	  SSD1306_DRIVER_mWriteReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET, 0);
+	  return XST_FAILURE;
+	}
+	SSD1306_DRIVER_mWriteReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG10_OFFSET, PERF_SNAPSHOT);
+	if ( SSD1306_DRIVER_mReadReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG16_OFFSET) <= rom_cycles){
+	  xil_printf ("Error counting the ROM cycles\n");
+	  SSD1306_DRIVER_mWriteReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET, 0);
+	  return XST_FAILURE;
+	}
+	SSD1306_DRIVER_mWriteReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG10_OFFSET, PERF_CLEAR);
+	SSD1306_DRIVER_mWriteReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG10_OFFSET, PERF_SNAPSHOT);
+	if ( SSD1306_DRIVER_mReadReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG16_OFFSET) >= rom_cycles){
+	  xil_printf ("Error clearing the ROM cycles\n");
+	  SSD1306_DRIVER_mWriteReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET, 0);
+	  return XST_FAILURE;
+	}
+	SSD1306_DRIVER_mWriteReg (baseaddr, SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET, 0);
+
+	xil_printf("   - performance counters snapshot/clear passed\n\n\r");
+
 	return XST_SUCCESS;
 }
@@ -5,13 +5,20 @@
 	(
 		// Users to add parameters here
         parameter integer SCLK_DIVIDER = 20,
+        parameter integer FIFO_DEPTH = 256,
 		// User parameters ends
 		// Do not modify the parameters beyond this line
 
 
+		// Parameters of Axi Master Bus Interface M00_AXI
+		parameter integer C_M00_AXI_BURST_LEN	= 16,
+		parameter integer C_M00_AXI_ADDR_WIDTH	= 32,
+		parameter integer C_M00_AXI_DATA_WIDTH	= 32,
+
+
 		// Parameters of Axi Slave Bus Interface S00_AXI
 		parameter integer C_S00_AXI_DATA_WIDTH	= 32,
-		parameter integer C_S00_AXI_ADDR_WIDTH	= 4
+		parameter integer C_S00_AXI_ADDR_WIDTH	= 7
 	)
 	(
 		// Users to add ports here
@@ -22,6 +29,7 @@
         output ssd1306_cs,
         output ssd1306_sdin,
         output ssd1306_sclk,
+        output irq, // level high
 		// User ports ends
 		// Do not modify the ports beyond this line
 
@@ -47,28 +55,132 @@
 		output wire [C_S00_AXI_DATA_WIDTH-1 : 0] s00_axi_rdata,
 		output wire [1 : 0] s00_axi_rresp,
 		output wire  s00_axi_rvalid,
-		input wire  s00_axi_rready
+		input wire  s00_axi_rready,
+
+		// Ports of Axi Master Bus Interface M00_AXI (read only, clocked with
+		// s00_axi_aclk)
+		output wire [C_M00_AXI_ADDR_WIDTH-1 : 0] m00_axi_araddr,
+		output wire [7 : 0] m00_axi_arlen,
+		output wire [2 : 0] m00_axi_arsize,
+		output wire [1 : 0] m00_axi_arburst,
+		output wire [3 : 0] m00_axi_arcache,
+		output wire [2 : 0] m00_axi_arprot,
+		output wire  m00_axi_arvalid,
+		input wire  m00_axi_arready,
+		input wire [C_M00_AXI_DATA_WIDTH-1 : 0] m00_axi_rdata,
+		input wire [1 : 0] m00_axi_rresp,
+		input wire  m00_axi_rlast,
+		input wire  m00_axi_rvalid,
+		output wire  m00_axi_rready
 	);
+    localparam IRQ_EVENTS_NB = 4;
+
 // Instantiation of Axi Bus Interface S00_AXI
+    wire [C_S00_AXI_DATA_WIDTH - 7:0] slv_reg0_unused;
     wire should_turn_power_on;
+    wire should_sleep;
+    wire should_stream;
     wire is_din_u8;
     wire is_din_data;
     wire [C_S00_AXI_DATA_WIDTH - 1:0] din;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] sclk_divider;
     wire should_send_din;
     wire is_busy;
+    wire is_idle;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] fifo_wdata;
+    wire fifo_wr;
+    wire fifo_rd;
+    wire [C_S00_AXI_DATA_WIDTH + 1:0] fifo_dout;
+    wire is_fifo_empty;
+    wire is_fifo_full;
+    wire [$clog2(FIFO_DEPTH):0] fifo_level;
+    wire [$clog2(FIFO_DEPTH):0] fifo_space;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] dma_addr;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] dma_length;
+    wire should_start_dma;
+    wire dma_fifo_wr;
+    wire [C_M00_AXI_DATA_WIDTH - 1:0] dma_fifo_wdata;
+    wire is_dma_busy;
+    wire has_dma_failed;
+    wire has_dma_finished;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] irq_enable;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] irq_clear;
+    wire [IRQ_EVENTS_NB - 1:0] irq_status;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] perf_command;
+    wire is_powered_on;
+    wire is_asleep;
+    wire is_running_rom;
+    wire is_word_taken;
+    wire is_word_u8;
+    wire is_word_data;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] perf_words_nb;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] perf_command_bytes_nb;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] perf_data_bytes_nb;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] perf_busy_cycles;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] perf_idle_cycles;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] perf_rom_cycles;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] perf_longest_gap_cycles;
+    wire [6:0] perf_overflows;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] script_word;
+    wire script_wr;
+    wire [C_S00_AXI_DATA_WIDTH - 1:0] script_run_addr;
+    wire script_fifo_wr;
+    wire is_fifo_over_half = fifo_level > FIFO_DEPTH / 2;
+    // The FIFO is being drained as long as the DMA is fetching words into it,
+    // it holds entries or the driver is still shifting the last of them out.
+    wire is_fifo_draining = is_dma_busy || !is_fifo_empty || !is_idle;
 	ssd1306_driver_v1_0_S00_AXI # (
 		.C_S_AXI_DATA_WIDTH(C_S00_AXI_DATA_WIDTH),
 		.C_S_AXI_ADDR_WIDTH(C_S00_AXI_ADDR_WIDTH)
 	) ssd1306_driver_v1_0_S00_AXI_inst (
         .slv_reg0({
-            {C_S00_AXI_DATA_WIDTH - 4{1'bZ}},
+            slv_reg0_unused,
+            should_sleep,
+            should_stream,
             is_din_u8,
             is_din_data,
             should_send_din,
             should_turn_power_on
         }),
         .slv_reg1(din),
-        .slv_reg2({ {C_S00_AXI_DATA_WIDTH - 1{1'b0}}, is_busy}),
+        .slv_reg2({
+            {C_S00_AXI_DATA_WIDTH - 7{1'b0}},
+            is_asleep,
+            is_fifo_over_half,
+            has_dma_failed,
+            is_dma_busy,
+            is_fifo_full,
+            is_fifo_draining,
+            is_busy
+        }),
+        .slv_reg3(sclk_divider),
+        .slv_reg4(fifo_wdata),
+        .slv_reg4_wren(fifo_wr),
+        .slv_reg5({
+            {C_S00_AXI_DATA_WIDTH / 2 - $clog2(FIFO_DEPTH) - 1{1'b0}},
+            fifo_space,
+            {C_S00_AXI_DATA_WIDTH / 2 - $clog2(FIFO_DEPTH) - 1{1'b0}},
+            fifo_level
+        }),
+        .slv_reg6(dma_addr),
+        .slv_reg7(dma_length),
+        .slv_reg7_wren(should_start_dma),
+        .slv_reg8(irq_enable),
+        .slv_reg9({{C_S00_AXI_DATA_WIDTH - IRQ_EVENTS_NB{1'b0}}, irq_status}),
+        .slv_reg9_w1c(irq_clear),
+        .slv_reg10({{C_S00_AXI_DATA_WIDTH - 7{1'b0}}, perf_overflows}),
+        .slv_reg10_w1(perf_command),
+        .slv_reg11(perf_words_nb),
+        .slv_reg12(perf_command_bytes_nb),
+        .slv_reg13(perf_data_bytes_nb),
+        .slv_reg14(perf_busy_cycles),
+        .slv_reg15(perf_idle_cycles),
+        .slv_reg16(perf_rom_cycles),
+        .slv_reg17(perf_longest_gap_cycles),
+        .slv_reg18(script_word),
+        .slv_reg18_wren(script_wr),
+        .slv_reg19(script_run_addr),
+        .slv_reg19_wren(script_fifo_wr),
 		.S_AXI_ACLK(s00_axi_aclk),
 		.S_AXI_ARESETN(s00_axi_aresetn),
 		.S_AXI_AWADDR(s00_axi_awaddr),
@@ -93,16 +205,100 @@
 	);
 
 	// Add user logic here
+
+    // Every entry carries the word along with is_din_u8/is_din_data as they
+    // are set in slv_reg0 at the time of the push, the words fetched by the
+    // DMA are always 32-bit data. A write to slv_reg19 pushes an entry with
+    // both flags clear, which runs the script at the address written, see
+    // ssd1306_driver, so commands pushed through slv_reg4 are always marked
+    // 8-bit. Entries pushed while the power is off are dropped.
+    fifo #(
+        .WIDTH(C_S00_AXI_DATA_WIDTH + 2),
+        .DEPTH(FIFO_DEPTH)
+    ) fifo_inst (
+        .clk(s00_axi_aclk),
+        .clear(!should_turn_power_on),
+        .wr(fifo_wr || script_fifo_wr || dma_fifo_wr),
+        .din(
+            fifo_wr ?
+                {is_din_u8 || !is_din_data, is_din_data, fifo_wdata} :
+            script_fifo_wr ?
+                {1'b0, 1'b0, script_run_addr} :
+                {1'b0, 1'b1, dma_fifo_wdata}
+        ),
+        .rd(fifo_rd),
+        .dout(fifo_dout),
+        .is_empty(is_fifo_empty),
+        .is_full(is_fifo_full),
+        .level(fifo_level),
+        .space(fifo_space)
+    );
+
+    // Fetches the frame at dma_addr into the FIFO, a write of dma_length
+    // starts the transfer. The words go out in the order they are stored in,
+    // i.e. the 512-byte page-major layout that the data path expects.
+    assign m00_axi_arsize = $clog2(C_M00_AXI_DATA_WIDTH / 8);
+    assign m00_axi_arburst = 2'b01; // INCR
+    assign m00_axi_arcache = 4'b0011; // normal non-cacheable bufferable
+    assign m00_axi_arprot = 3'b000;
+    frame_dma #(
+        .ADDR_WIDTH(C_M00_AXI_ADDR_WIDTH),
+        .DATA_WIDTH(C_M00_AXI_DATA_WIDTH),
+        .BURST_LEN(C_M00_AXI_BURST_LEN),
+        .SPACE_WIDTH($clog2(FIFO_DEPTH) + 1)
+    ) frame_dma_inst (
+        .clk(s00_axi_aclk),
+        .resetn(s00_axi_aresetn),
+        .should_start(should_start_dma && should_turn_power_on),
+        .start_addr(dma_addr),
+        .length(dma_length),
+        .should_abort(!should_turn_power_on),
+        .is_fifo_wr_blocked(fifo_wr || script_fifo_wr),
+        .fifo_space(fifo_space),
+        .fifo_wr(dma_fifo_wr),
+        .fifo_wdata(dma_fifo_wdata),
+        .is_busy(is_dma_busy),
+        .has_failed(has_dma_failed),
+        .has_finished(has_dma_finished),
+        .m_axi_araddr(m00_axi_araddr),
+        .m_axi_arlen(m00_axi_arlen),
+        .m_axi_arvalid(m00_axi_arvalid),
+        .m_axi_arready(m00_axi_arready),
+        .m_axi_rdata(m00_axi_rdata),
+        .m_axi_rresp(m00_axi_rresp),
+        .m_axi_rlast(m00_axi_rlast),
+        .m_axi_rvalid(m00_axi_rvalid),
+        .m_axi_rready(m00_axi_rready)
+    );
+
     ssd1306_driver #(
         .SCLK_DIVIDER(SCLK_DIVIDER)
     ) ssd1306_driver_inst (
         .clk(s00_axi_aclk),
+        .sclk_divider(sclk_divider[7:0]),
         .should_turn_power_on(should_turn_power_on),
+        .should_sleep(should_sleep),
+        .should_stream(should_stream),
         .should_send_din(should_send_din),
         .is_din_u8(is_din_u8),
         .is_din_data(is_din_data),
         .din(din),
+        .is_fifo_empty(is_fifo_empty),
+        .is_fifo_din_u8(fifo_dout[C_S00_AXI_DATA_WIDTH + 1]),
+        .is_fifo_din_data(fifo_dout[C_S00_AXI_DATA_WIDTH]),
+        .fifo_din(fifo_dout[C_S00_AXI_DATA_WIDTH - 1:0]),
+        .fifo_rd(fifo_rd),
+        .script_wr(script_wr),
+        .script_waddr(script_word[23:16]),
+        .script_wdata(script_word[15:0]),
         .is_busy(is_busy),
+        .is_idle(is_idle),
+        .is_powered_on(is_powered_on),
+        .is_asleep(is_asleep),
+        .is_running_rom(is_running_rom),
+        .is_word_taken(is_word_taken),
+        .is_word_u8(is_word_u8),
+        .is_word_data(is_word_data),
         .ssd1306_vdd(ssd1306_vdd),
         .ssd1306_reset(ssd1306_reset),
         .ssd1306_vcc(ssd1306_vcc),
@@ -111,6 +307,70 @@
         .ssd1306_sdin(ssd1306_sdin),
         .ssd1306_sclk(ssd1306_sclk)
     );
+
+    // The events are the falling edges of the corresponding status bits in
+    // slv_reg2, so that the software can check the status bit, enable the
+    // event and sleep without missing the edge in between.
+    localparam
+        IRQ_SEND_DONE = 0,
+        IRQ_FIFO_DRAINED = 1,
+        IRQ_DMA_DONE = 2,
+        IRQ_FIFO_HALF_EMPTY = 3;
+    reg was_busy = 0;
+    reg was_fifo_draining = 0;
+    reg was_fifo_over_half = 0;
+    always @(posedge s00_axi_aclk) begin
+        was_busy <= is_busy;
+        was_fifo_draining <= is_fifo_draining;
+        was_fifo_over_half <= is_fifo_over_half;
+    end
+
+    wire [IRQ_EVENTS_NB - 1:0] irq_events;
+    assign irq_events[IRQ_SEND_DONE] = was_busy && !is_busy;
+    assign irq_events[IRQ_FIFO_DRAINED] = was_fifo_draining && !is_fifo_draining;
+    assign irq_events[IRQ_DMA_DONE] = has_dma_finished;
+    assign irq_events[IRQ_FIFO_HALF_EMPTY] = was_fifo_over_half && !is_fifo_over_half;
+
+    interrupt_controller #(
+        .EVENTS_NB(IRQ_EVENTS_NB)
+    ) interrupt_controller_inst (
+        .clk(s00_axi_aclk),
+        .resetn(s00_axi_aresetn),
+        .events(irq_events),
+        .enable(irq_enable[IRQ_EVENTS_NB - 1:0]),
+        .clear(irq_clear[IRQ_EVENTS_NB - 1:0]),
+        .status(irq_status),
+        .irq(irq)
+    );
+
+    // Writing 1 to bit 0 of slv_reg10 snapshots the counters into
+    // slv_reg11-17, and their overflow bits into slv_reg10, 1 to bit 1 clears
+    // them.
+    localparam
+        PERF_SNAPSHOT = 0,
+        PERF_CLEAR = 1;
+    perf_counters #(
+        .WIDTH(C_S00_AXI_DATA_WIDTH)
+    ) perf_counters_inst (
+        .clk(s00_axi_aclk),
+        .resetn(s00_axi_aresetn),
+        .should_snapshot(perf_command[PERF_SNAPSHOT]),
+        .should_clear(perf_command[PERF_CLEAR]),
+        .is_powered_on(is_powered_on),
+        .is_running_rom(is_running_rom),
+        .is_busy(is_busy),
+        .is_word_taken(is_word_taken),
+        .is_word_u8(is_word_u8),
+        .is_word_data(is_word_data),
+        .words_nb(perf_words_nb),
+        .command_bytes_nb(perf_command_bytes_nb),
+        .data_bytes_nb(perf_data_bytes_nb),
+        .busy_cycles(perf_busy_cycles),
+        .idle_cycles(perf_idle_cycles),
+        .rom_cycles(perf_rom_cycles),
+        .longest_gap_cycles(perf_longest_gap_cycles),
+        .overflows(perf_overflows)
+    );
 	// User logic ends
 
 	endmodule
@@ -10,13 +10,36 @@
 		// Width of S_AXI data bus
 		parameter integer C_S_AXI_DATA_WIDTH	= 32,
 		// Width of S_AXI address bus
-		parameter integer C_S_AXI_ADDR_WIDTH	= 4
+		parameter integer C_S_AXI_ADDR_WIDTH	= 7
 	)
 	(
 		// Users to add ports here
         output reg [C_S_AXI_DATA_WIDTH-1:0] slv_reg0,
 	    output reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg1,
         input [C_S_AXI_DATA_WIDTH-1:0]      slv_reg2,
+        output reg [C_S_AXI_DATA_WIDTH-1:0] slv_reg3, // SCLK divider, 0 for SCLK_DIVIDER
+        output reg [C_S_AXI_DATA_WIDTH-1:0] slv_reg4,
+        output reg                          slv_reg4_wren, // pulse on write
+        input [C_S_AXI_DATA_WIDTH-1:0]      slv_reg5,
+        output reg [C_S_AXI_DATA_WIDTH-1:0] slv_reg6,
+        output reg [C_S_AXI_DATA_WIDTH-1:0] slv_reg7,
+        output reg                          slv_reg7_wren, // pulse on write
+        output reg [C_S_AXI_DATA_WIDTH-1:0] slv_reg8,
+        input [C_S_AXI_DATA_WIDTH-1:0]      slv_reg9,
+        output reg [C_S_AXI_DATA_WIDTH-1:0] slv_reg9_w1c, // pulse, bits written with 1
+        input [C_S_AXI_DATA_WIDTH-1:0]      slv_reg10,
+        output reg [C_S_AXI_DATA_WIDTH-1:0] slv_reg10_w1, // pulse, bits written with 1
+        input [C_S_AXI_DATA_WIDTH-1:0]      slv_reg11,
+        input [C_S_AXI_DATA_WIDTH-1:0]      slv_reg12,
+        input [C_S_AXI_DATA_WIDTH-1:0]      slv_reg13,
+        input [C_S_AXI_DATA_WIDTH-1:0]      slv_reg14,
+        input [C_S_AXI_DATA_WIDTH-1:0]      slv_reg15,
+        input [C_S_AXI_DATA_WIDTH-1:0]      slv_reg16,
+        input [C_S_AXI_DATA_WIDTH-1:0]      slv_reg17,
+        output reg [C_S_AXI_DATA_WIDTH-1:0] slv_reg18,
+        output reg                          slv_reg18_wren, // pulse on write
+        output reg [C_S_AXI_DATA_WIDTH-1:0] slv_reg19,
+        output reg                          slv_reg19_wren, // pulse on write
 		// User ports ends
 		// Do not modify the ports beyond this line
 
@@ -100,12 +123,11 @@
 	// ADDR_LSB = 2 for 32 bits (n downto 2)
 	// ADDR_LSB = 3 for 64 bits (n downto 3)
 	localparam integer ADDR_LSB = (C_S_AXI_DATA_WIDTH/32) + 1;
-	localparam integer OPT_MEM_ADDR_BITS = 1;
+	localparam integer OPT_MEM_ADDR_BITS = 4;
 	//----------------------------------------------
 	//-- Signals for user logic register space example
 	//------------------------------------------------
-	//-- Number of Slave Registers 4
-	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg3;
+	//-- Number of Slave Registers 18
 	wire	 slv_reg_rden;
 	wire	 slv_reg_wren;
 	reg [C_S_AXI_DATA_WIDTH-1:0]	 reg_data_out;
@@ -218,39 +240,104 @@
 	begin
 	  if ( S_AXI_ARESETN == 1'b0 )
 	    begin
-	      slv_reg0 <= { 31'b0, 1'bZ };
-	      slv_reg1 <= { 23'b0, 1'bZ, 8'bZ };
+	      slv_reg0 <= 0;
+	      slv_reg1 <= 0;
 	      slv_reg3 <= 0;
+	      slv_reg4 <= 0;
+	      slv_reg4_wren <= 1'b0;
+	      slv_reg6 <= 0;
+	      slv_reg7 <= 0;
+	      slv_reg7_wren <= 1'b0;
+	      slv_reg8 <= 0;
+	      slv_reg9_w1c <= 0;
+	      slv_reg10_w1 <= 0;
+	      slv_reg18 <= 0;
+	      slv_reg18_wren <= 1'b0;
+	      slv_reg19 <= 0;
+	      slv_reg19_wren <= 1'b0;
 	    end 
 	  else begin
+	    slv_reg4_wren <= 1'b0;
+	    slv_reg7_wren <= 1'b0;
+	    slv_reg9_w1c <= 0;
+	    slv_reg10_w1 <= 0;
+	    slv_reg18_wren <= 1'b0;
+	    slv_reg19_wren <= 1'b0;
 	    if (slv_reg_wren)
 	      begin
 	        case ( axi_awaddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] )
-	          2'h0:
+	          5'h00:
 	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
 	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
 	                // Respective byte enables are asserted as per write strobes 
 	                // Slave register 0
 	                slv_reg0[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
 	              end  
-	          2'h1:
+	          5'h01:
 	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
 	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
 	                // Respective byte enables are asserted as per write strobes 
 	                // Slave register 1
 	                slv_reg1[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
 	              end  
-	          2'h3:
+	          5'h03:
 	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
 	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
 	                // Respective byte enables are asserted as per write strobes 
 	                // Slave register 3
 	                slv_reg3[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
 	              end  
+	          5'h04: begin
+	            // Slave register 4 - every write pushes a word into the TX FIFO
+	            slv_reg4 <= S_AXI_WDATA;
+	            slv_reg4_wren <= 1'b1;
+	          end
+	          5'h06:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 6
+	                slv_reg6[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h07: begin
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 7 - every write starts a DMA transfer
+	                slv_reg7[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	            slv_reg7_wren <= 1'b1;
+	          end
+	          5'h08:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 8
+	                slv_reg8[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h09:
+	            // Slave register 9 - the bits written with 1 clear the status
+	            slv_reg9_w1c <= S_AXI_WDATA;
+	          5'h0A:
+	            // Slave register 10 - the bits written with 1 are commands
+	            slv_reg10_w1 <= S_AXI_WDATA;
+	          5'h12: begin
+	            // Slave register 18 - every write stores a word of the script memory
+	            slv_reg18 <= S_AXI_WDATA;
+	            slv_reg18_wren <= 1'b1;
+	          end
+	          5'h13: begin
+	            // Slave register 19 - every write queues a script run in the TX FIFO
+	            slv_reg19 <= S_AXI_WDATA;
+	            slv_reg19_wren <= 1'b1;
+	          end
 	          default : begin
 	                      slv_reg0 <= slv_reg0;
 	                      slv_reg1 <= slv_reg1;
 	                      slv_reg3 <= slv_reg3;
+	                      slv_reg6 <= slv_reg6;
+	                      slv_reg7 <= slv_reg7;
+	                      slv_reg8 <= slv_reg8;
 	                    end
 	        endcase
 	      end
@@ -359,10 +446,26 @@
 	begin
 	      // Address decoding for reading registers
 	      case ( axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] )
-	        2'h0   : reg_data_out <= slv_reg0;
-	        2'h1   : reg_data_out <= slv_reg1;
-	        2'h2   : reg_data_out <= slv_reg2;
-	        2'h3   : reg_data_out <= slv_reg3;
+	        5'h00   : reg_data_out <= slv_reg0;
+	        5'h01   : reg_data_out <= slv_reg1;
+	        5'h02   : reg_data_out <= slv_reg2;
+	        5'h03   : reg_data_out <= slv_reg3;
+	        5'h04   : reg_data_out <= slv_reg4;
+	        5'h05   : reg_data_out <= slv_reg5;
+	        5'h06   : reg_data_out <= slv_reg6;
+	        5'h07   : reg_data_out <= slv_reg7;
+	        5'h08   : reg_data_out <= slv_reg8;
+	        5'h09   : reg_data_out <= slv_reg9;
+	        5'h0A   : reg_data_out <= slv_reg10;
+	        5'h0B   : reg_data_out <= slv_reg11;
+	        5'h0C   : reg_data_out <= slv_reg12;
+	        5'h0D   : reg_data_out <= slv_reg13;
+	        5'h0E   : reg_data_out <= slv_reg14;
+	        5'h0F   : reg_data_out <= slv_reg15;
+	        5'h10   : reg_data_out <= slv_reg16;
+	        5'h11   : reg_data_out <= slv_reg17;
+	        5'h12   : reg_data_out <= slv_reg18;
+	        5'h13   : reg_data_out <= slv_reg19;
 	        default : reg_data_out <= 0;
 	      endcase
 	end
@@ -0,0 +1,45 @@
+`include "timescale.vh"
+
+// First-word-fall-through FIFO, dout holds the oldest entry whenever !is_empty.
+module fifo #(
+    parameter WIDTH = 32,
+    parameter DEPTH = 256
+) (
+    input clk,
+    input clear, // drop all entries
+    input wr, // push din
+    input [WIDTH - 1:0] din,
+    input rd, // pop dout
+    output [WIDTH - 1:0] dout,
+    output is_empty,
+    output is_full,
+    output [$clog2(DEPTH):0] level, // number of entries held
+    output [$clog2(DEPTH):0] space // number of entries that can be pushed
+);
+    localparam ADDR_WIDTH = $clog2(DEPTH);
+
+    reg [WIDTH - 1:0] mem [0:DEPTH - 1];
+    reg [ADDR_WIDTH:0] wr_ptr = 0;
+    reg [ADDR_WIDTH:0] rd_ptr = 0;
+
+    assign level = wr_ptr - rd_ptr;
+    assign space = DEPTH - level;
+    assign is_empty = wr_ptr == rd_ptr;
+    assign is_full = level == DEPTH;
+    assign dout = mem[rd_ptr[ADDR_WIDTH - 1:0]];
+
+    always @(posedge clk)
+        if (wr && !is_full)
+            mem[wr_ptr[ADDR_WIDTH - 1:0]] <= din;
+
+    always @(posedge clk)
+        if (clear) begin
+            wr_ptr <= 0;
+            rd_ptr <= 0;
+        end else begin
+            if (wr && !is_full)
+                wr_ptr <= wr_ptr + 1;
+            if (rd && !is_empty)
+                rd_ptr <= rd_ptr + 1;
+        end
+endmodule
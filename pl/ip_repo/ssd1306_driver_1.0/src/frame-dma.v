@@ -0,0 +1,119 @@
+`include "timescale.vh"
+
+// Reads length bytes starting at start_addr over an AXI4 read channel and
+// pushes them, a word at a time, into the TX FIFO.
+//
+// The reads are split into INCR bursts of up to BURST_LEN words that never
+// cross a 4KB boundary. Only one burst is outstanding at a time and a burst is
+// issued only once the FIFO has space for all of its beats, so rready never
+// has to be deasserted on account of the FIFO.
+module frame_dma #(
+    parameter ADDR_WIDTH = 32,
+    parameter DATA_WIDTH = 32,
+    parameter BURST_LEN = 16,
+    parameter SPACE_WIDTH = 9
+) (
+    input clk,
+    input resetn,
+    input should_start, // pulse, start_addr and length are sampled with it
+    input [ADDR_WIDTH - 1:0] start_addr, // word aligned
+    input [ADDR_WIDTH - 1:0] length, // in bytes, multiple of 4
+    input should_abort, // do not issue any more bursts
+    input is_fifo_wr_blocked, // the FIFO write port is taken this cycle
+    input [SPACE_WIDTH - 1:0] fifo_space,
+    output fifo_wr,
+    output [DATA_WIDTH - 1:0] fifo_wdata,
+    output is_busy,
+    output reg has_failed = 0, // a read returned SLVERR/DECERR
+    output reg has_finished = 0, // pulse at the end of a transfer
+    // AXI4 read address channel
+    output reg [ADDR_WIDTH - 1:0] m_axi_araddr = 0,
+    output reg [7:0] m_axi_arlen = 0,
+    output reg m_axi_arvalid = 0,
+    input m_axi_arready,
+    // AXI4 read data channel
+    input [DATA_WIDTH - 1:0] m_axi_rdata,
+    input [1:0] m_axi_rresp,
+    input m_axi_rlast,
+    input m_axi_rvalid,
+    output m_axi_rready
+);
+    localparam BYTES_PER_WORD = DATA_WIDTH / 8;
+    localparam WORD_SHIFT = $clog2(BYTES_PER_WORD);
+
+    localparam
+        Idle = 0,
+        IssueBurst = 1,
+        WaitAddress = 2,
+        WaitData = 3,
+        StateMax = 4;
+    reg [$clog2(StateMax) - 1:0] state = Idle;
+
+    reg [ADDR_WIDTH - 1:0] addr = 0;
+    reg [ADDR_WIDTH - WORD_SHIFT - 1:0] words_left = 0;
+
+    // Beats to the next 4KB boundary and the length of the next burst.
+    wire [12 - WORD_SHIFT:0] words_to_boundary =
+        (13'h1000 - addr[11:0]) >> WORD_SHIFT;
+    wire [ADDR_WIDTH - WORD_SHIFT - 1:0] burst_len =
+        words_left < BURST_LEN && words_left < words_to_boundary ? words_left :
+        words_to_boundary < BURST_LEN ? words_to_boundary :
+        BURST_LEN;
+
+    assign m_axi_rready = state == WaitData && !is_fifo_wr_blocked;
+    assign fifo_wr = m_axi_rvalid && m_axi_rready;
+    assign fifo_wdata = m_axi_rdata;
+    assign is_busy = state != Idle;
+
+    always @(posedge clk)
+        if (!resetn) begin
+            m_axi_arvalid <= 0;
+            has_finished <= 0;
+            has_failed <= 0;
+            state <= Idle;
+        end else begin
+            has_finished <= 0;
+
+            case (state)
+
+            Idle:
+                if (should_start && length >= BYTES_PER_WORD) begin
+                    addr <= start_addr;
+                    words_left <= length >> WORD_SHIFT;
+                    has_failed <= 0;
+                    state <= IssueBurst;
+                end
+
+            IssueBurst:
+                if (should_abort || words_left == 0) begin
+                    has_finished <= 1;
+                    state <= Idle;
+                end else if (fifo_space >= burst_len) begin
+                    m_axi_araddr <= addr;
+                    m_axi_arlen <= burst_len - 1;
+                    m_axi_arvalid <= 1;
+                    addr <= addr + (burst_len << WORD_SHIFT);
+                    words_left <= words_left - burst_len;
+                    state <= WaitAddress;
+                end
+
+            WaitAddress:
+                if (m_axi_arready) begin
+                    m_axi_arvalid <= 0;
+                    state <= WaitData;
+                end
+
+            WaitData:
+                if (m_axi_rvalid && m_axi_rready) begin
+                    if (m_axi_rresp[1])
+                        has_failed <= 1;
+                    if (m_axi_rlast)
+                        state <= IssueBurst;
+                end
+
+            default:
+                state <= Idle;
+
+            endcase
+        end
+endmodule
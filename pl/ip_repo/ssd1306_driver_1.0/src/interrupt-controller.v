@@ -0,0 +1,24 @@
+`include "timescale.vh"
+
+// Latches event pulses into status bits and drives a level-high irq while
+// any enabled status bit is set. A status bit is cleared by writing 1 to it,
+// an event in the same cycle wins over the clear.
+module interrupt_controller #(
+    parameter EVENTS_NB = 4
+) (
+    input clk,
+    input resetn,
+    input [EVENTS_NB - 1:0] events, // pulses
+    input [EVENTS_NB - 1:0] enable,
+    input [EVENTS_NB - 1:0] clear, // pulses, write-1-to-clear
+    output reg [EVENTS_NB - 1:0] status = 0,
+    output irq
+);
+    assign irq = |(status & enable);
+
+    always @(posedge clk)
+        if (!resetn)
+            status <= 0;
+        else
+            status <= (status & ~clear) | events;
+endmodule
@@ -0,0 +1,144 @@
+`include "timescale.vh"
+
+// Free-running counters of what the driver spends its time on, for reading
+// over AXI4-Lite. The counters keep going, the software sees their snapshots:
+// should_snapshot copies all of them at once, should_clear zeroes them, both
+// in the same cycle take the snapshot before the clear.
+//
+//  - words_nb, the words (1 or 4 bytes) taken by the spi_master,
+//  - command_bytes_nb and data_bytes_nb, their bytes by D/C#,
+//  - busy_cycles, the cycles with the panel selected, i.e. bits being shifted,
+//  - idle_cycles, the cycles powered on with nothing to shift and no ROM
+//    running, i.e. waiting for the CPU,
+//  - rom_cycles, the cycles of running the power on/off ROM or a script,
+//  - longest_gap_cycles, the most cycles that the spi_master sat idle between
+//    two words while powered on, counted from the first word after a clear.
+//
+// A counter that reaches its maximum stays there, it does not wrap, and sets
+// its bit of overflows, in the order above, until the next clear. At 100MHz
+// the cycle counters get there after ~43s.
+module perf_counters #(
+    parameter WIDTH = 32
+) (
+    input clk,
+    input resetn,
+    input should_snapshot, // pulse
+    input should_clear, // pulse
+    input is_powered_on,
+    input is_running_rom,
+    input is_busy,
+    input is_word_taken, // pulse
+    input is_word_u8,
+    input is_word_data,
+    output reg [WIDTH - 1:0] words_nb = 0,
+    output reg [WIDTH - 1:0] command_bytes_nb = 0,
+    output reg [WIDTH - 1:0] data_bytes_nb = 0,
+    output reg [WIDTH - 1:0] busy_cycles = 0,
+    output reg [WIDTH - 1:0] idle_cycles = 0,
+    output reg [WIDTH - 1:0] rom_cycles = 0,
+    output reg [WIDTH - 1:0] longest_gap_cycles = 0,
+    output reg [6:0] overflows = 0
+);
+    localparam [WIDTH - 1:0] MAX = {WIDTH{1'b1}};
+    localparam
+        WORDS = 0,
+        COMMAND_BYTES = 1,
+        DATA_BYTES = 2,
+        BUSY = 3,
+        IDLE = 4,
+        ROM = 5,
+        GAP = 6;
+
+    reg [WIDTH - 1:0] words_counter = 0;
+    reg [WIDTH - 1:0] command_bytes_counter = 0;
+    reg [WIDTH - 1:0] data_bytes_counter = 0;
+    reg [WIDTH - 1:0] busy_counter = 0;
+    reg [WIDTH - 1:0] idle_counter = 0;
+    reg [WIDTH - 1:0] rom_counter = 0;
+    reg [WIDTH - 1:0] gap_counter = 0;
+    reg [WIDTH - 1:0] longest_gap = 0;
+    reg has_taken_word = 0;
+    reg [6:0] overflowed = 0;
+
+    always @(posedge clk) begin
+        if (!resetn || should_clear) begin
+            words_counter <= 0;
+            command_bytes_counter <= 0;
+            data_bytes_counter <= 0;
+            busy_counter <= 0;
+            idle_counter <= 0;
+            rom_counter <= 0;
+            gap_counter <= 0;
+            longest_gap <= 0;
+            has_taken_word <= 0;
+            overflowed <= 0;
+        end else begin
+            if (is_word_taken) begin
+                if (words_counter == MAX)
+                    overflowed[WORDS] <= 1;
+                else
+                    words_counter <= words_counter + 1;
+                if (!is_word_data) begin
+                    if (command_bytes_counter == MAX)
+                        overflowed[COMMAND_BYTES] <= 1;
+                    else
+                        command_bytes_counter <= command_bytes_counter + 1;
+                end else begin
+                    if (data_bytes_counter > MAX - (is_word_u8 ? 1 : 4)) begin
+                        data_bytes_counter <= MAX;
+                        overflowed[DATA_BYTES] <= 1;
+                    end else
+                        data_bytes_counter <= data_bytes_counter + (is_word_u8 ? 1 : 4);
+                end
+
+                if (has_taken_word && gap_counter > longest_gap)
+                    longest_gap <= gap_counter;
+                has_taken_word <= 1;
+                gap_counter <= 0;
+            end else if (is_powered_on && !is_busy) begin
+                if (gap_counter == MAX)
+                    overflowed[GAP] <= 1;
+                else
+                    gap_counter <= gap_counter + 1;
+            end
+
+            if (is_busy) begin
+                if (busy_counter == MAX)
+                    overflowed[BUSY] <= 1;
+                else
+                    busy_counter <= busy_counter + 1;
+            end
+            if (is_running_rom) begin
+                if (rom_counter == MAX)
+                    overflowed[ROM] <= 1;
+                else
+                    rom_counter <= rom_counter + 1;
+            end else if (is_powered_on && !is_busy) begin
+                if (idle_counter == MAX)
+                    overflowed[IDLE] <= 1;
+                else
+                    idle_counter <= idle_counter + 1;
+            end
+        end
+
+        if (!resetn) begin
+            words_nb <= 0;
+            command_bytes_nb <= 0;
+            data_bytes_nb <= 0;
+            busy_cycles <= 0;
+            idle_cycles <= 0;
+            rom_cycles <= 0;
+            longest_gap_cycles <= 0;
+            overflows <= 0;
+        end else if (should_snapshot) begin
+            words_nb <= words_counter;
+            command_bytes_nb <= command_bytes_counter;
+            data_bytes_nb <= data_bytes_counter;
+            busy_cycles <= busy_counter;
+            idle_cycles <= idle_counter;
+            rom_cycles <= rom_counter;
+            longest_gap_cycles <= longest_gap;
+            overflows <= overflowed;
+        end
+    end
+endmodule
@@ -0,0 +1,32 @@
+`include "timescale.vh"
+
+// The instruction memory of the scripts that the PS uploads, see
+// ssd1306_driver. It reads like the ROM of the power sequences, with a cycle
+// of latency, and takes a word at a time from the AXI side. Every word starts
+// as the End instruction, so a script run from where nothing was written
+// stops right away.
+module script_ram #(
+    parameter DEPTH = 256,
+    parameter [15:0] INIT = 16'hBC00
+) (
+    input clk,
+    input wr, // store wdata at waddr
+    input [$clog2(DEPTH) - 1:0] waddr,
+    input [15:0] wdata,
+    input [$clog2(DEPTH) - 1:0] raddr,
+    output reg [15:0] rdata = 0
+);
+    reg [15:0] mem [0:DEPTH - 1];
+
+    initial begin: init
+        integer i;
+        for (i = 0; i < DEPTH; i = i + 1)
+            mem[i] = INIT;
+    end
+
+    always @(posedge clk) begin
+        if (wr)
+            mem[waddr] <= wdata;
+        rdata <= mem[raddr];
+    end
+endmodule
@@ -2,99 +2,77 @@
 
 `define WIDTH_32 32
 
+// Shifts out 8 or 32-bit units MSB first, SCLK idles high and mosi changes on
+// its falling edges. With should_stream set the next unit is taken right after
+// the last bit of the current one, so a burst of units goes out back-to-back
+// with cs held low throughout.
 module spi_master #(
-    parameter SCLK_DIVIDER = 20
+    parameter SCLK_DIVIDER = 20, // used while sclk_divider is 0
+    parameter DIVIDER_WIDTH = 8
 ) (
     input clk, // reference clock
+    input [DIVIDER_WIDTH - 1:0] sclk_divider, // SCLK period in clk cycles minus 1, 0 for SCLK_DIVIDER
     input is_data_ready, // signal whether data is ready for sending
     input is_data_u8, // data can be passed in as either 8 or 32 bit entity
     input [`WIDTH_32 - 1:0] data, // data to be sent
+    input should_stream, // take the next data without a gap, keep cs low
     output mosi, // output bit
     output sclk, // SPI clock
-    output reg cs, // mosi is read of when cs is low
-    output is_busy // are we still putting bits on mosi?
+    output reg cs = 1, // mosi is read of when cs is low
+    output is_busy, // are we still putting bits on mosi?
+    output is_data_taken // data is picked up on this clk edge
 );
     localparam WIDTH_32 = `WIDTH_32;
     localparam WIDTH_8 = 8;
 
-    wire is_sending; 
-    reg is_sclk_falling = 0;
-    reg is_sclk_rising = 0;
-    reg [1:0] byte_cnt = 0;
-    
-    reg [WIDTH_32 - 1:0] dout = 8'h00;
+    // The divider is taken over only while nothing is being sent, so that no
+    // transfer goes out with mixed SCLK periods. Below SCLK_DIVIDER_MIN the
+    // rising and falling edges of sclk would fall on the same counts.
+    localparam SCLK_DIVIDER_MIN = 4;
+    reg [DIVIDER_WIDTH - 1:0] divider = SCLK_DIVIDER;
     always @(posedge clk)
-        if (is_data_ready && !is_sending && byte_cnt == 0)
-            dout <= data;
-        else
-            if (is_sending && is_sclk_falling)
-                dout <= { dout[WIDTH_32 - 2:0], 1'b0 };
-                    
-    assign mosi = is_data_u8 ? dout[WIDTH_8 - 1] : dout[WIDTH_32 - 1];
-    
-    always @(posedge clk)
-        if (is_data_ready || (!is_data_u8 && byte_cnt > 0 && cs == 1))
-            cs <= 0;
-        else
-            if (is_sending)
-                cs <= 0;
-            else
-                cs <= 1;
-    
-    reg [$clog2(WIDTH_8):0] counter = 0;
-    always @(posedge clk)
-        if (is_sending) begin
-            if (is_sclk_rising) begin
-                // keep ticking (<=) to deliver the LSB
-                if (counter <= WIDTH_8 + 1)
-                    counter <= counter + 1;
-                else
-                    counter <= 0;
-            end
-        end else
-            counter <= 0;
-    
-    always @(posedge clk)
-        if (counter == WIDTH_8 - 1 && is_sclk_rising)
-            if (is_data_u8)
-                byte_cnt <= 0;
-            else if (!is_data_u8 && byte_cnt == 3)
-                byte_cnt <= 0;
+        if (cs)
+            if (sclk_divider == 0)
+                divider <= SCLK_DIVIDER;
+            else if (sclk_divider < SCLK_DIVIDER_MIN)
+                divider <= SCLK_DIVIDER_MIN;
             else
-                byte_cnt <= byte_cnt + 1;
+                divider <= sclk_divider;
+
+    wire [DIVIDER_WIDTH - 1:0] dividerb2 = divider / 2;
+
+    // Every bit takes divider + 1 cycles: sclk is low for the first half of
+    // them, rises in the middle (where the panel samples mosi) and the next
+    // bit is put on mosi as sclk falls again.
+    reg [DIVIDER_WIDTH - 1:0] sclk_counter = 0;
+    reg [WIDTH_32 - 1:0] dout = 0;
+    reg [$clog2(WIDTH_32):0] bits_nb = 0; // bits left in dout, the one on mosi included
+
+    wire is_bit_done = sclk_counter == divider;
+    wire is_unit_done = is_bit_done && bits_nb == 1;
+    assign is_data_taken = is_data_ready && (cs || (should_stream && is_unit_done));
 
-    reg [$clog2(SCLK_DIVIDER):0] sclk_counter = 0;
     always @(posedge clk)
-        if (is_sending)
-            if (sclk_counter < SCLK_DIVIDER)
+        if (is_data_taken) begin
+            dout <= is_data_u8 ?
+                { data[WIDTH_8 - 1:0], {WIDTH_32 - WIDTH_8{1'b0}} } :
+                data;
+            bits_nb <= is_data_u8 ? WIDTH_8 : WIDTH_32;
+            sclk_counter <= 0;
+            cs <= 0;
+        end else if (!cs) begin
+            if (!is_bit_done)
                 sclk_counter <= sclk_counter + 1;
-            else
+            else if (bits_nb > 1) begin
+                dout <= { dout[WIDTH_32 - 2:0], 1'b0 };
+                bits_nb <= bits_nb - 1;
                 sclk_counter <= 0;
-        else
-            sclk_counter <= 0;
-            
-    localparam 
-        SCLK_DIVIDERb2 = SCLK_DIVIDER / 2,
-        SCLK_DIVIDERl1 = SCLK_DIVIDER - 1;
-    always @(posedge clk) 
-        if (is_sending) begin
-            if (sclk_counter == SCLK_DIVIDERb2)
-                is_sclk_rising <= 1;
-            else
-                is_sclk_rising <= 0;
-            
-            if (sclk_counter == SCLK_DIVIDERl1)
-                is_sclk_falling <= 1;
-            else
-                is_sclk_falling <= 0;
+            end else
+                cs <= 1;
         end
-    
-    assign is_sending = (
-        (cs == 0 && counter == 0) || 
-        (counter > 0 && counter < WIDTH_8) ||
-        (counter == WIDTH_8 && sclk_counter > SCLK_DIVIDERb2)
-    );
-    assign sclk = is_sending ? sclk_counter >= SCLK_DIVIDERb2 : 1'b1;
-    assign is_busy = (byte_cnt > 0 || !cs);
-    
+
+    assign mosi = dout[WIDTH_32 - 1];
+    assign sclk = cs ? 1'b1 : sclk_counter >= dividerb2;
+    assign is_busy = !cs;
+
 endmodule
@@ -6,12 +6,30 @@ module ssd1306_driver #(
     SCLK_DIVIDER = 20
 )(
     input clk,
+    input [7:0] sclk_divider, // SCLK period in clk cycles minus 1, 0 for SCLK_DIVIDER
     input should_turn_power_on,
+    input should_sleep, // blank the display with its power left on, see Sleep
+    input should_stream, // send the FIFO entries in bursts, see Streaming
     input should_send_din,
     input is_din_u8,
     input is_din_data,
     input [`DATA_WIDTH - 1:0] din,
+    input is_fifo_empty, // the entries below are valid when !is_fifo_empty
+    input is_fifo_din_u8,
+    input is_fifo_din_data,
+    input [`DATA_WIDTH - 1:0] fifo_din,
+    input script_wr, // store script_wdata in the script memory at script_waddr
+    input [7:0] script_waddr,
+    input [15:0] script_wdata,
+    output reg fifo_rd = 0, // pulse to pop the FIFO entry
     output is_busy,
+    output is_idle,
+    output is_powered_on,
+    output is_asleep,
+    output is_running_rom,
+    output is_word_taken, // pulse, the spi_master took the word below
+    output is_word_u8,
+    output is_word_data,
     output ssd1306_vdd,
     output ssd1306_reset,
     output ssd1306_vcc,
@@ -41,8 +59,24 @@ module ssd1306_driver #(
      * +------+-------+
      * 00wwwwwwdddddddd - send SSD1306 command [7:0], fetch next inst. after [13:8] 8ms
      * 01wwwwwwwwwwwwwd - set VDD on/off [0:0], fetch next inst. after [13:1] 1ms
-     * 10wwwwwwwwwwwwwd - set RES# on/of [0:0], fetch next inst. after [13:1] 1ms
+     * 100wwwwwwwwwwwwd - set RES# on/of [0:0], fetch next inst. after [12:1] 1ms
      * 11wwwwwwwwwwwwwd - set VCC/VBAT on/off, fetch next inst. after [13:1] 1ms
+     * 101000xxdddddddd - send [7:0] as data (D/C# high)
+     * 101001xxaaaaaaaa - jump to [7:0]
+     * 101010nnnnnnnnnn - set the loop counter to [9:0]
+     * 101011xxaaaaaaaa - loop: decrement the counter, jump to [7:0] while it is
+     *                    above 0, i.e. the instructions from [7:0] up to here
+     *                    run [9:0] of the set times in all
+     * 101100wwwwwwwwww - fetch next inst. after [9:0] 1ms
+     * 101111xxxxxxxxxx - end of script (so are 101101 and 101110)
+     *
+     * The power sequences run from the ROM, from their base up to their max,
+     * the scripts from the script memory, which the PS writes through
+     * script_wr, from the address a FIFO entry says up to an End. A FIFO entry
+     * with neither is_din_data nor is_din_u8 set runs the script at [7:0] of
+     * the word, in order with the entries around it. The loop counter is one,
+     * so loops do not nest. A script is stopped at its next instruction by
+     * a power off, the way out of one that never ends.
      *
      * Power ON instructions:
      *   1. 40C8, VDD 0 (active low), wait 100*1ms
@@ -62,13 +96,22 @@ module ssd1306_driver #(
      *  15. 0000, (Sequential COM pins, Disable COM Left/Right remap)
      *  16. 0020, MemoryAddressingMode
      *  17. 0000, (Horizontal Addressing Mode)
-     *  18. 32AF, Display ON, wait 50*4ms
+     *  18. 00A8, MultiplexRatio:
+     *  19. 001F, (32 rows, the panel's COM0-COM31)
+     *  20. 0040, DisplayStartLine 0 (rows 32-63 are the off-screen half)
+     *  21. 32AF, Display ON, wait 50*4ms
      *
      * Power OFF instructions:
      *   1. 00AE; Display OFF, no wait
      *   2. C0C9; VCC 1 (active low), wait 100*1ms
      *   3. 4001; VDD 1 (active low), no wait
      *
+     * Sleep instructions:
+     *   1. 00AE; Display OFF, no wait
+     *
+     * Resume instructions:
+     *   1. 00AF; Display ON, no wait
+     *
      * Notes:
      *  1. The commands are described in [1].
      *  2. The specification of the MCU is available in [2].
@@ -78,36 +121,80 @@ module ssd1306_driver #(
      */
     localparam
         IP_POWER_ON_BASE = 0,
-        IP_POWER_ON_MAX = 18;
+        IP_POWER_ON_MAX = 21;
     localparam
         IP_POWER_OFF_BASE = IP_POWER_ON_MAX,
         IP_POWER_OFF_MAX = IP_POWER_OFF_BASE + 3;
+    localparam
+        IP_SLEEP_BASE = IP_POWER_OFF_MAX,
+        IP_SLEEP_MAX = IP_SLEEP_BASE + 1;
+    localparam
+        IP_RESUME_BASE = IP_SLEEP_MAX,
+        IP_RESUME_MAX = IP_RESUME_BASE + 1;
     localparam
         ROM_DEPTH = 256,
         ROM_WIDTH = 16;
     reg [$clog2(ROM_DEPTH) - 1:0] ip = 0; // the ROM is 256 words deep
     reg [$clog2(ROM_DEPTH) - 1:0] ip_max = 0;
-    wire [ROM_WIDTH - 1:0] instruction; // word in ROM is 16 bits wide
+    wire [ROM_WIDTH - 1:0] rom_instruction; // word in ROM is 16 bits wide
     power_on_off_sequence power_on_off_sequence_inst(
         clk,
         ip,
-        instruction
+        rom_instruction
+    );
+
+    wire [ROM_WIDTH - 1:0] script_instruction;
+    script_ram #(
+        .DEPTH(ROM_DEPTH)
+    ) script_ram_inst (
+        .clk(clk),
+        .wr(script_wr),
+        .waddr(script_waddr),
+        .wdata(script_wdata),
+        .raddr(ip),
+        .rdata(script_instruction)
     );
 
+    reg is_executing_script = 0;
+    wire [ROM_WIDTH - 1:0] instruction =
+        is_executing_script ? script_instruction : rom_instruction;
+    reg [9:0] loop_counter = 0;
+
     reg is_data_ready = 0;
     reg is_data_u8 = 0;
     reg [DATA_WIDTH - 1:0] data = { DATA_WIDTH {1'b0} };
+
+    // While streaming, the spi_master takes the FIFO entries straight from its
+    // output for as long as they go with the same D/C#. An entry that has been
+    // taken is held back until fifo_rd has popped it.
+    wire is_streaming;
+    wire is_fifo_din_u8_cmd = !is_fifo_din_data || is_fifo_din_u8;
+    wire is_fifo_din_script = !is_fifo_din_data && !is_fifo_din_u8;
+    wire can_stream_fifo_din =
+        !is_fifo_empty && !fifo_rd && !is_fifo_din_script &&
+        is_fifo_din_data == oled_dc;
+    wire is_data_taken;
+    wire is_spi_data_u8 = is_streaming ? is_fifo_din_u8_cmd : is_data_u8;
+    assign is_word_taken = is_data_taken;
+    assign is_word_u8 = is_spi_data_u8;
+    assign is_word_data = oled_dc;
     spi_master #(
         .SCLK_DIVIDER(SCLK_DIVIDER)
     ) spi_master_inst (
         .clk(clk),
-        .is_data_ready(is_data_ready),
-        .is_data_u8(is_data_u8),
-        .data(is_data_ready ? data : { DATA_WIDTH {1'b0} }),
+        .sclk_divider(sclk_divider),
+        .is_data_ready(is_streaming ? can_stream_fifo_din : is_data_ready),
+        .is_data_u8(is_spi_data_u8),
+        .data(
+            is_streaming ? fifo_din :
+            is_data_ready ? data : { DATA_WIDTH {1'b0} }
+        ),
+        .should_stream(is_streaming),
         .mosi(ssd1306_sdin),
         .sclk(ssd1306_sclk),
         .cs(ssd1306_cs),
-        .is_busy(is_busy)
+        .is_busy(is_busy),
+        .is_data_taken(is_data_taken)
     );
 
     reg [(16 - 2 - 1) - 1:0] wait_time = 0;
@@ -124,7 +211,11 @@ module ssd1306_driver #(
     );
 
     reg is_power_on = 0;
+    reg is_sleeping = 0;
     reg is_executing_rom = 0;
+    assign is_powered_on = is_power_on;
+    assign is_asleep = is_sleeping;
+    assign is_running_rom = is_executing_rom;
     reg [1:0] send_sturtup_delay = 0;
 
     localparam
@@ -135,9 +226,14 @@ module ssd1306_driver #(
         ExecuteInstruction = 4,
         WaitSendDone = 5,
         WaitTimeout = 6,
-        StateMax = 7;
+        Streaming = 7,
+        StateMax = 8;
     reg [$clog2(StateMax) - 1:0] state = Idle;
-    always @(posedge clk)
+    assign is_idle = state == Idle;
+    assign is_streaming = state == Streaming;
+    always @(posedge clk) begin
+        fifo_rd <= 0;
+
         case (state)
 
         Idle: begin
@@ -155,6 +251,22 @@ module ssd1306_driver #(
                 is_executing_rom <= 1;
                 state <= IncrementIp;
             end else
+            // Sleep: the display goes blank, but VDD, VCC and the charge pump
+            // setting stay as they are, and so do GDDRAM and the rest of the
+            // configuration, which the FIFO and din can still write to.
+            if (should_sleep && is_power_on && !is_sleeping) begin
+                ip <= IP_SLEEP_BASE;
+                ip_max <= IP_SLEEP_MAX;
+                is_executing_rom <= 1;
+                state <= IncrementIp;
+            end else
+            // Resume from sleep, showing whatever GDDRAM holds by then.
+            if (!should_sleep && is_sleeping) begin
+                ip <= IP_RESUME_BASE;
+                ip_max <= IP_RESUME_MAX;
+                is_executing_rom <= 1;
+                state <= IncrementIp;
+            end else
             // Send data that is provided by the caller.
             if (should_send_din && is_power_on && !is_busy) begin
                 oled_dc <= is_din_data;
@@ -167,15 +279,52 @@ module ssd1306_driver #(
                 else
                     is_data_u8 <= is_din_u8;
 
+                send_sturtup_delay <= 2;
+                state <= WaitSendDone;
+            end else
+            // Run the script that the FIFO entry points at.
+            if (!is_fifo_empty && is_fifo_din_script && is_power_on && !is_busy) begin
+                fifo_rd <= 1;
+                ip <= fifo_din[7:0];
+                is_executing_script <= 1;
+                is_executing_rom <= 1;
+                state <= IncrementIp;
+            end else
+            // Send the data that has been queued in the FIFO in a burst, the
+            // entries are picked up in Streaming.
+            if (!is_fifo_empty && is_power_on && !is_busy && should_stream) begin
+                oled_dc <= is_fifo_din_data;
+                state <= Streaming;
+            end else
+            // Send data that has been queued in the FIFO, an entry at a time.
+            if (!is_fifo_empty && is_power_on && !is_busy) begin
+                fifo_rd <= 1;
+                oled_dc <= is_fifo_din_data;
+                data <= fifo_din;
+                is_data_ready <= 1;
+
+                // Commands are always 8bit wide.
+                if (!is_fifo_din_data)
+                    is_data_u8 <= 1;
+                else
+                    is_data_u8 <= is_fifo_din_u8;
+
                 send_sturtup_delay <= 2;
                 state <= WaitSendDone;
             end
         end
 
         IncrementIp: begin // to deal with 1cc latency of ROM
-            if (ip == ip_max) begin
+            if (is_executing_script && !should_turn_power_on) begin
+                is_executing_script <= 0;
+                is_executing_rom <= 0;
+                state <= Idle;
+            end else
+            if (!is_executing_script && ip == ip_max) begin
                 is_executing_rom <= 0;
-                is_power_on <= ip == IP_POWER_ON_MAX;
+                if (ip == IP_POWER_ON_MAX || ip == IP_POWER_OFF_MAX)
+                    is_power_on <= ip == IP_POWER_ON_MAX;
+                is_sleeping <= ip == IP_SLEEP_MAX;
                 state <= Idle;
             end else begin
                 ip <= ip + 1;
@@ -202,9 +351,52 @@ module ssd1306_driver #(
             end
 
             2'b10: begin
-                oled_reset <= instruction[0:0];
-                wait_time <= instruction[13:1];
-                state <= WaitTimeout;
+                if (!instruction[13]) begin
+                    oled_reset <= instruction[0:0];
+                    wait_time <= instruction[12:1];
+                    state <= WaitTimeout;
+                end else
+                case (instruction[12:10])
+                3'b000: begin // data
+                    oled_dc <= 1;
+                    is_data_ready <= 1;
+                    is_data_u8 <= 1;
+                    data <= instruction[7:0];
+                    wait_time <= 0;
+                    send_sturtup_delay <= 2;
+                    state <= WaitSendDone;
+                end
+
+                3'b001: begin // jump
+                    ip <= instruction[7:0];
+                    state <= IncrementIp;
+                end
+
+                3'b010: begin // set the loop counter
+                    loop_counter <= instruction[9:0];
+                    state <= IncrementIp;
+                end
+
+                3'b011: begin // loop
+                    if (loop_counter > 1) begin
+                        loop_counter <= loop_counter - 1;
+                        ip <= instruction[7:0];
+                    end else
+                        loop_counter <= 0;
+                    state <= IncrementIp;
+                end
+
+                3'b100: begin // wait
+                    wait_time <= instruction[9:0];
+                    state <= WaitTimeout;
+                end
+
+                default: begin // end
+                    is_executing_script <= 0;
+                    is_executing_rom <= 0;
+                    state <= Idle;
+                end
+                endcase
             end
 
             2'b11: begin
@@ -230,6 +422,17 @@ module ssd1306_driver #(
                 end
         end
 
+        // Keep feeding the spi_master with the FIFO entries, it shifts them
+        // out without a gap for as long as the next one is there by the time
+        // the last bit of the current one is out. The burst ends when it runs
+        // dry or the next entry goes with the other D/C#.
+        Streaming: begin
+            if (is_data_taken)
+                fifo_rd <= 1;
+            else if (!is_busy && !can_stream_fifo_din && !fifo_rd)
+                state <= Idle;
+        end
+
         WaitTimeout: begin
             if (wait_time > 0 && !is_timer_enabled)
                 is_timer_enabled <= 1;
@@ -245,5 +448,6 @@ module ssd1306_driver #(
             state <= Idle;
 
         endcase
+    end
 
 endmodule
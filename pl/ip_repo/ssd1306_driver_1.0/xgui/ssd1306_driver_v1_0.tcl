@@ -8,6 +8,7 @@ proc init_gui { IPINST } {
   ipgui::add_param $IPINST -name "C_S00_AXI_BASEADDR" -parent ${Page_0}
   ipgui::add_param $IPINST -name "C_S00_AXI_HIGHADDR" -parent ${Page_0}
   ipgui::add_param $IPINST -name "SCLK_DIVIDER" -parent ${Page_0}
+  ipgui::add_param $IPINST -name "FIFO_DEPTH" -parent ${Page_0}
 
 
 }
@@ -21,6 +22,15 @@ proc validate_PARAM_VALUE.SCLK_DIVIDER { PARAM_VALUE.SCLK_DIVIDER } {
 	return true
 }
 
+proc update_PARAM_VALUE.FIFO_DEPTH { PARAM_VALUE.FIFO_DEPTH } {
+	# Procedure called to update FIFO_DEPTH when any of the dependent parameters in the arguments change
+}
+
+proc validate_PARAM_VALUE.FIFO_DEPTH { PARAM_VALUE.FIFO_DEPTH } {
+	# Procedure called to validate FIFO_DEPTH
+	return true
+}
+
 proc update_PARAM_VALUE.C_S00_AXI_DATA_WIDTH { PARAM_VALUE.C_S00_AXI_DATA_WIDTH } {
 	# Procedure called to update C_S00_AXI_DATA_WIDTH when any of the dependent parameters in the arguments change
 }
@@ -73,3 +83,8 @@ proc update_MODELPARAM_VALUE.SCLK_DIVIDER { MODELPARAM_VALUE.SCLK_DIVIDER PARAM_
 	set_property value [get_property value ${PARAM_VALUE.SCLK_DIVIDER}] ${MODELPARAM_VALUE.SCLK_DIVIDER}
 }
 
+proc update_MODELPARAM_VALUE.FIFO_DEPTH { MODELPARAM_VALUE.FIFO_DEPTH PARAM_VALUE.FIFO_DEPTH } {
+	# Procedure called to set VHDL generic/Verilog parameter value(s) based on TCL parameter value
+	set_property value [get_property value ${PARAM_VALUE.FIFO_DEPTH}] ${MODELPARAM_VALUE.FIFO_DEPTH}
+}
+
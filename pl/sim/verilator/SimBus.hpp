@@ -0,0 +1,231 @@
+#ifndef SIM_BUS_HPP
+#define SIM_BUS_HPP
+
+#include <unordered_map>
+#include "xil_types.h"
+#include "Vssd1306_driver_v1_0.h"
+#include "BusAddressMap.hpp"
+#include "Ssd1306Model.hpp"
+
+/*
+ * AxiSim clocks the Verilated ssd1306_driver_v1_0 and plays the PS side of it:
+ * the register accesses of the driver become AXI4-Lite transactions on
+ * S00_AXI, the reads of the frame DMA on M00_AXI are served from the words
+ * that were flushed for the device, and the SPI pins are watched and, with a
+ * panel set, fed into it.
+ *
+ * The IP is clocked at 100MHz, as FCLK_CLK0 on the board, a cycle is a tick
+ * of that clock.
+ */
+class AxiSim {
+
+public:
+    static const u32 CLK_HZ = 100000000;
+
+    AxiSim():
+        cycles(0),
+        busCycles(0),
+        sclkBitsNb(0),
+        csLowCycles(0),
+        panel(0),
+        dmaAddr(0),
+        dmaBeatsNb(0),
+        wasSclkHigh(true) {
+        top.s00_axi_aresetn = 0;
+        top.s00_axi_awprot = 0;
+        top.s00_axi_arprot = 0;
+        top.s00_axi_wstrb = 0xF;
+        top.m00_axi_rresp = 0;
+        for (int i = 0; i < 16; ++i)
+            tick();
+        top.s00_axi_aresetn = 1;
+        tick();
+    }
+
+    ~AxiSim() {
+        top.final();
+    }
+
+    static inline
+    AxiSim *&instance() {
+        /* The simulation that SimBus goes to. */
+        static AxiSim *sim = 0;
+        return sim;
+    }
+
+    inline
+    void tick() {
+        /* One cycle of the clock, the inputs change on the falling edge. */
+        top.s00_axi_aclk = 0;
+        top.eval();
+        driveDma();
+        top.eval();
+
+        bool isArHandshake = top.m00_axi_arvalid && top.m00_axi_arready;
+        bool isRHandshake = top.m00_axi_rvalid && top.m00_axi_rready;
+        u32 araddr = top.m00_axi_araddr;
+        u32 arlen = top.m00_axi_arlen;
+
+        top.s00_axi_aclk = 1;
+        top.eval();
+        ++cycles;
+
+        if (isArHandshake) {
+            dmaAddr = araddr;
+            dmaBeatsNb = arlen + 1;
+        }
+        if (isRHandshake) {
+            dmaAddr += 4;
+            --dmaBeatsNb;
+        }
+
+        /* The panel samples mosi on the rising edges of sclk. */
+        bool isSclkHigh = top.ssd1306_sclk;
+        if (!top.ssd1306_cs) {
+            ++csLowCycles;
+            if (isSclkHigh && !wasSclkHigh)
+                ++sclkBitsNb;
+        }
+        wasSclkHigh = isSclkHigh;
+
+        if (panel) {
+            if (!top.ssd1306_reset)
+                panel->reset();
+            else
+                panel->sampleSpi(top.ssd1306_cs, top.ssd1306_dc, isSclkHigh, top.ssd1306_sdin);
+        }
+    }
+
+    inline
+    void run(u64 cyclesNb) {
+        while (cyclesNb-- > 0)
+            tick();
+    }
+
+    inline
+    u32 read(u32 offset) {
+        /* An AXI4-Lite read, the address goes first, then the data. */
+        u64 start = cycles;
+        top.s00_axi_araddr = offset;
+        top.s00_axi_arvalid = 1;
+        top.s00_axi_rready = 1;
+        while (!top.s00_axi_arready)
+            tick();
+        tick();
+        top.s00_axi_arvalid = 0;
+        while (!top.s00_axi_rvalid)
+            tick();
+        u32 value = top.s00_axi_rdata;
+        tick();
+        top.s00_axi_rready = 0;
+        busCycles += cycles - start;
+        return value;
+    }
+
+    inline
+    void write(u32 offset, u32 value) {
+        /* An AXI4-Lite write, address and data at once, then the response. */
+        u64 start = cycles;
+        top.s00_axi_awaddr = offset;
+        top.s00_axi_awvalid = 1;
+        top.s00_axi_wdata = value;
+        top.s00_axi_wvalid = 1;
+        top.s00_axi_bready = 1;
+        while (!(top.s00_axi_awready && top.s00_axi_wready))
+            tick();
+        tick();
+        top.s00_axi_awvalid = 0;
+        top.s00_axi_wvalid = 0;
+        while (!top.s00_axi_bvalid)
+            tick();
+        tick();
+        top.s00_axi_bready = 0;
+        busCycles += cycles - start;
+    }
+
+    inline
+    void flush(const void *p, u32 size) {
+        /* What the DMA sees is what was last flushed, as with the L2 cache. */
+        const u32 *words = (const u32 *)p;
+        u32 addr = addressMap.map(p, size);
+        for (u32 i = 0; i < size / 4; ++i)
+            memory[addr + 4 * i] = words[i];
+    }
+
+    inline
+    u32 toBusAddress(const void *p) const {
+        /* The address that p was flushed at. */
+        return addressMap.toBusAddress(p);
+    }
+
+    u64             cycles;
+        /* Clock cycles since the start. */
+
+    u64             busCycles;
+        /* Cycles spent in register accesses. */
+
+    u64             sclkBitsNb;
+        /* Bits clocked into the panel. */
+
+    u64             csLowCycles;
+        /* Cycles with the panel selected. */
+
+    Ssd1306Model    *panel;
+        /* The panel on the SPI pins, none by default. */
+
+    Vssd1306_driver_v1_0 top;
+        /* The IP. */
+
+private:
+    inline
+    void driveDma() {
+        /* A burst at a time, the beats follow without wait states. */
+        top.m00_axi_arready = dmaBeatsNb == 0;
+        top.m00_axi_rvalid = dmaBeatsNb > 0;
+        top.m00_axi_rlast = dmaBeatsNb == 1;
+        top.m00_axi_rdata = dmaBeatsNb > 0 ? memory[dmaAddr] : 0;
+    }
+
+    u32             dmaAddr;
+        /* Address of the next beat of the burst in flight. */
+
+    u32             dmaBeatsNb;
+        /* Beats left in the burst in flight, 0 for none. */
+
+    bool            wasSclkHigh;
+        /* The level of sclk on the previous cycle. */
+
+    BusAddressMap   addressMap;
+        /* The bus addresses of the flushed buffers. */
+
+    std::unordered_map<u32, u32> memory;
+        /* The words flushed for the device, by address. */
+};
+
+/*
+ * The Bus of Ssd1306 for the simulation, it goes to AxiSim::instance().
+ */
+struct SimBus {
+
+    static inline
+    u32 read(u32 offset) {
+        return AxiSim::instance()->read(offset);
+    }
+
+    static inline
+    void write(u32 offset, u32 value) {
+        AxiSim::instance()->write(offset, value);
+    }
+
+    static inline
+    u32 toBusAddress(const void *p) {
+        return AxiSim::instance()->toBusAddress(p);
+    }
+
+    static inline
+    void flushForDevice(const void *p, u32 size) {
+        AxiSim::instance()->flush(p, size);
+    }
+};
+
+#endif // SIM_BUS_HPP
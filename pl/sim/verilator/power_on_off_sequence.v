@@ -0,0 +1,23 @@
+`include "timescale.vh"
+
+// Behavioral stand-in for the power_on_off_sequence block memory of the IP,
+// a 256x16 ROM with the one clock cycle of read latency of the block memory.
+// The contents come from ip/power_on_off_sequence.coe, which the Makefile turns
+// into power_on_off_sequence.vh.
+module power_on_off_sequence (
+    input clka,
+    input [7:0] addra,
+    output reg [15:0] douta = 0
+);
+    reg [15:0] rom [0:255];
+
+    initial begin: load
+        integer i;
+        for (i = 0; i < 256; i = i + 1)
+            rom[i] = 0;
+        `include "power_on_off_sequence.vh"
+    end
+
+    always @(posedge clka)
+        douta <= rom[addra];
+endmodule
@@ -0,0 +1,237 @@
+/*
+ * Plays the animations of the demo through FramePresenter and the Ssd1306
+ * driver against the RTL of the ssd1306_driver IP, Verilated, and reports per
+ * animation:
+ *
+ *  - the bus cycles, the clock cycles spent in AXI4-Lite register accesses,
+ *    per frame,
+ *  - the frames per second the IP could show, with the frames presented
+ *    back-to-back and every one of them shifted out before the next,
+ *  - the SPI utilization, the share of the time that SCLK spent clocking bits
+ *    into the panel,
+ *  - the frames that Ssd1306Model, fed from the SPI pins, showed differently
+ *    from what was presented.
+ *
+ * Then it puts the display to sleep, stages a frame while it is asleep and
+ * wakes it up, and reports the time from the resume to the frame being shown
+ * against the time the cold power on took.
+ *
+ * Last, it loads a script that fills GDDRAM with a checkerboard into the
+ * script memory, runs it and reports the cycles it took, with the register
+ * writes of the run and the bytes of GDDRAM that came out wrong.
+ *
+ * Usage: ssd1306-sim [-d divider] [-n] [-f frames]
+ *
+ *  -d  the SCLK divider (slv_reg3), 0 for the SCLK_DIVIDER of the IP,
+ *  -n  no streaming, every queued word is a transfer of its own,
+ *  -f  the most frames to play of every animation.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "verilated.h"
+#include "SimBus.hpp"
+#include "Ssd1306Model.hpp"
+#include "Ssd1306.hpp"
+#include "FramePresenter.hpp"
+#include "FrameDecoder.hpp"
+
+#define NELS(a) (sizeof(a) / sizeof(a[0]))
+
+typedef Ssd1306<SimBus> Display;
+typedef FramePresenter<Display> Presenter;
+
+static const u8 packed1[] =
+#include "380r-packed.inc"
+
+static const u8 packed2[] =
+#include "aha2-packed.inc"
+
+static const u8 packed3[] =
+#include "cascade-packed.inc"
+
+static const u8 packed4[] =
+#include "eyes-packed.inc"
+
+struct Animation {
+    const char  *name;
+    const u8    *packed;
+    size_t      packedSize;
+};
+
+static bool
+isShown(const Ssd1306Model *panel, const u32 frame[])
+{
+    /* Whether the panel shows frame, pixel for pixel. */
+    for (int y = 0; y < Ssd1306Model::PANEL_ROWS_NB; ++y) {
+        for (int x = 0; x < Ssd1306Model::WIDTH; ++x) {
+            u32 word = frame[(y / 8) * 32 + x / 4];
+            bool isLit = (word >> ((3 - x % 4) * 8 + y % 8)) & 1;
+            if (isLit != panel->getPixel(x, y))
+                return false;
+        }
+    }
+    return true;
+}
+
+int
+main(int argc, char *argv[]) {
+
+    static
+    Animation animations[] = {
+        { "380r", packed1, sizeof(packed1) },
+        { "aha2", packed2, sizeof(packed2) },
+        { "cascade", packed3, sizeof(packed3) },
+        { "eyes", packed4, sizeof(packed4) },
+    };
+
+    int divider = 0;
+    bool shouldStream = true;
+    size_t framesMax = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:nf:")) != -1) {
+        switch (opt) {
+        case 'd':
+            divider = atoi(optarg);
+            break;
+        case 'n':
+            shouldStream = false;
+            break;
+        case 'f':
+            framesMax = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-d divider] [-n] [-f frames]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Verilated::commandArgs(argc, argv);
+
+    static
+    AxiSim sim;
+    AxiSim::instance() = &sim;
+
+    static
+    Ssd1306Model panel;
+    sim.panel = &panel;
+
+    static
+    Display display;
+
+    static
+    Presenter presenter(&display);
+
+    /* The power on sequence of the ROM runs for ~400ms of simulated time. */
+    display.setSclkDivider(divider);
+    display.setStreaming(shouldStream);
+    display.powerOn();
+    display.waitForFifoDrained();
+    u64 powerOnCycles = sim.cycles;
+    fprintf(stderr, "Powered on after %llu cycles, SCLK divider %d.\n",
+        (unsigned long long)powerOnCycles, (int)display.getSclkDivider());
+    int sclkCycles = display.getSclkDivider() + 1;
+
+    int rc = 0;
+    printf("%-10s %8s %12s %12s %10s %10s %8s\n",
+        "animation", "frames", "bus cycles", "cycles", "frames/s", "spi util", "wrong");
+    for (size_t a = 0; a < NELS(animations); ++a) {
+        Animation *animation = &animations[a];
+        FrameDecoder decoder(animation->packed, animation->packedSize);
+        u32 frame[FrameDecoder::WORDS_NB];
+        memset(frame, 0, sizeof(frame));
+
+        size_t framesNb = decoder.getFramesNb();
+        if (framesMax > 0 && framesNb > framesMax)
+            framesNb = framesMax;
+
+        presenter.invalidate();
+        u64 cycles = sim.cycles;
+        u64 busCycles = sim.busCycles;
+        u64 sclkBitsNb = sim.sclkBitsNb;
+        size_t wrongNb = 0;
+        for (size_t i = 0; i < framesNb; ++i) {
+            decoder.decode(frame);
+            presenter.present(frame);
+            display.waitForDmaDone();
+            display.waitForFifoDrained();
+            wrongNb += !isShown(&panel, frame);
+        }
+
+        /* Per frame. */
+        double frameCycles = (double)(sim.cycles - cycles) / framesNb;
+        printf("%-10s %8zu %12.0f %12.0f %10.1f %9.1f%% %8zu\n",
+            animation->name,
+            framesNb,
+            (sim.busCycles - busCycles) / (double)framesNb,
+            frameCycles,
+            AxiSim::CLK_HZ / frameCycles,
+            100.0 * (sim.sclkBitsNb - sclkBitsNb) * sclkCycles / (sim.cycles - cycles),
+            wrongNb
+        );
+        rc |= wrongNb > 0;
+    }
+
+    /* Sleep, stage the first frame of the first animation and wake up. */
+    FrameDecoder decoder(animations[0].packed, animations[0].packedSize);
+    u32 staged[FrameDecoder::WORDS_NB];
+    memset(staged, 0, sizeof(staged));
+    decoder.decode(staged);
+
+    display.sleep();
+    while (!display.isAsleep())
+        ;
+    presenter.invalidate();
+    presenter.present(staged);
+    display.waitForDmaDone();
+    display.waitForFifoDrained();
+    bool isBlank = !panel.isDisplayOn();
+
+    u64 cycles = sim.cycles;
+    display.resume();
+    display.waitForAwake(-1);
+    u64 resumeCycles = sim.cycles - cycles;
+    bool isWrong = !isShown(&panel, staged);
+
+    printf("\n%-10s %12s %12s %8s %8s\n", "wake", "cycles", "us", "blank", "wrong");
+    printf("%-10s %12llu %12.1f %8s %8s\n",
+        "cold", (unsigned long long)powerOnCycles,
+        powerOnCycles * 1e6 / AxiSim::CLK_HZ, "-", "-");
+    printf("%-10s %12llu %12.1f %8s %8s\n",
+        "resume", (unsigned long long)resumeCycles,
+        resumeCycles * 1e6 / AxiSim::CLK_HZ, isBlank ? "yes" : "no",
+        isWrong ? "yes" : "no");
+    rc |= !isBlank || isWrong;
+
+    /* A script that fills GDDRAM, columns of 0x55 and 0xAA in turn. */
+    static
+    Display::Script script;
+    const u8 pattern[] = { 0x55, 0xAA };
+    script.add(Display::ColumnAddress, (u8)0, Ssd1306Model::WIDTH - 1);
+    script.add(Display::PageAddress, (u8)0, Ssd1306Model::GDDRAM_PAGES_NB - 1);
+    script.beginLoop(Ssd1306Model::WIDTH * Ssd1306Model::GDDRAM_PAGES_NB / 2);
+    script.addData(pattern, sizeof(pattern));
+    script.endLoop();
+    int end = display.loadScript(0, script);
+
+    cycles = sim.cycles;
+    u32 writesNb = display.getMmioWritesNb();
+    display.runScript(0);
+    writesNb = display.getMmioWritesNb() - writesNb;
+    display.waitForFifoDrained();
+    u64 scriptCycles = sim.cycles - cycles;
+
+    int wrongNb = 0;
+    const u8 *gddram = panel.getGddram();
+    for (int i = 0; i < Ssd1306Model::WIDTH * Ssd1306Model::GDDRAM_PAGES_NB; ++i)
+        wrongNb += gddram[i] != pattern[i % 2];
+
+    printf("\n%-10s %8s %8s %12s %8s\n", "script", "words", "writes", "cycles", "wrong");
+    printf("%-10s %8d %8u %12llu %8d\n",
+        "checkers", end, writesNb, (unsigned long long)scriptCycles, wrongNb);
+    rc |= end < 0 || wrongNb > 0;
+
+    display.powerOff();
+    return rc;
+}
@@ -0,0 +1,74 @@
+`include "../verilog/timescale.vh"
+
+// Read-only AXI4 slave backed by a word array, for exercising AXI masters.
+//
+// The read data comes after READ_LATENCY cycles and rvalid is dropped at
+// random for a cycle when HAS_GAPS is set. Bursts that cross a 4KB boundary
+// or run outside of the memory are reported as errors.
+module axi_memory_model #(
+    parameter BASE_ADDR = 32'h0000_0000,
+    parameter MEM_WORDS = 4096,
+    parameter READ_LATENCY = 8,
+    parameter HAS_GAPS = 1
+) (
+    input clk,
+    input [31:0] araddr,
+    input [7:0] arlen,
+    input arvalid,
+    output reg arready = 0,
+    output reg [31:0] rdata = 0,
+    output [1:0] rresp,
+    output reg rlast = 0,
+    output reg rvalid = 0,
+    input rready
+);
+    reg [31:0] mem [0:MEM_WORDS - 1];
+
+    integer errors = 0;
+    integer bursts = 0;
+
+    reg [31:0] addr;
+    reg [8:0] beats_left = 0;
+    integer latency = 0;
+
+    assign rresp = 2'b00;
+
+    always @(posedge clk) begin
+        arready <= 0;
+
+        if (arvalid && !arready && beats_left == 0) begin
+            arready <= 1;
+            addr <= araddr;
+            beats_left <= arlen + 1;
+            latency <= READ_LATENCY;
+            bursts = bursts + 1;
+            if ((araddr & 12'hFFF) + ((arlen + 1) << 2) > 13'h1000) begin
+                $display("%t: ERROR: burst at %h of %0d beats crosses 4KB",
+                    $time, araddr, arlen + 1);
+                errors = errors + 1;
+            end
+            if (araddr < BASE_ADDR ||
+                araddr + ((arlen + 1) << 2) > BASE_ADDR + (MEM_WORDS << 2)) begin
+                $display("%t: ERROR: burst at %h is out of memory", $time, araddr);
+                errors = errors + 1;
+            end
+        end
+
+        if (rvalid && rready) begin
+            rvalid <= 0;
+            rlast <= 0;
+        end
+
+        if (beats_left > 0 && !arready) begin
+            if (latency > 0)
+                latency <= latency - 1;
+            else if ((!rvalid || rready) && !(HAS_GAPS && ($random & 3) == 0)) begin
+                rdata <= mem[(addr - BASE_ADDR) >> 2];
+                rvalid <= 1;
+                rlast <= beats_left == 1;
+                addr <= addr + 4;
+                beats_left <= beats_left - 1;
+            end
+        end
+    end
+endmodule
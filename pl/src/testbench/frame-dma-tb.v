@@ -0,0 +1,196 @@
+`include "../verilog/timescale.vh"
+
+// Runs frame_dma against axi_memory_model and checks that the words reach the
+// FIFO unchanged and in order, including a frame that straddles a 4KB page.
+module frame_dma_tb;
+
+    reg GCLK = 1;
+    always
+        #5 GCLK = ~GCLK;
+
+    reg resetn = 0;
+    initial begin
+        repeat(8) @(posedge GCLK);
+        resetn = 1;
+    end
+
+    localparam FIFO_DEPTH = 256;
+    localparam FRAME_BYTES = 512;
+
+    reg should_start = 0;
+    reg [31:0] start_addr = 0;
+    reg [31:0] length = 0;
+    reg should_abort = 0;
+    reg fifo_rd = 0;
+    wire fifo_wr;
+    wire [31:0] fifo_wdata;
+    wire [31:0] fifo_dout;
+    wire is_fifo_empty;
+    wire [$clog2(FIFO_DEPTH):0] fifo_space;
+    wire is_busy;
+    wire has_failed;
+    wire has_finished;
+    wire [31:0] araddr;
+    wire [7:0] arlen;
+    wire arvalid;
+    wire arready;
+    wire [31:0] rdata;
+    wire [1:0] rresp;
+    wire rlast;
+    wire rvalid;
+    wire rready;
+
+    fifo #(
+        .WIDTH(32),
+        .DEPTH(FIFO_DEPTH)
+    ) fifo_inst (
+        .clk(GCLK),
+        .clear(!resetn),
+        .wr(fifo_wr),
+        .din(fifo_wdata),
+        .rd(fifo_rd),
+        .dout(fifo_dout),
+        .is_empty(is_fifo_empty),
+        .is_full(),
+        .level(),
+        .space(fifo_space)
+    );
+
+    frame_dma #(
+        .SPACE_WIDTH($clog2(FIFO_DEPTH) + 1)
+    ) uut (
+        .clk(GCLK),
+        .resetn(resetn),
+        .should_start(should_start),
+        .start_addr(start_addr),
+        .length(length),
+        .should_abort(should_abort),
+        .is_fifo_wr_blocked(1'b0),
+        .fifo_space(fifo_space),
+        .fifo_wr(fifo_wr),
+        .fifo_wdata(fifo_wdata),
+        .is_busy(is_busy),
+        .has_failed(has_failed),
+        .has_finished(has_finished),
+        .m_axi_araddr(araddr),
+        .m_axi_arlen(arlen),
+        .m_axi_arvalid(arvalid),
+        .m_axi_arready(arready),
+        .m_axi_rdata(rdata),
+        .m_axi_rresp(rresp),
+        .m_axi_rlast(rlast),
+        .m_axi_rvalid(rvalid),
+        .m_axi_rready(rready)
+    );
+
+    axi_memory_model #(
+        .BASE_ADDR(32'h0010_0000),
+        .MEM_WORDS(4096)
+    ) memory (
+        .clk(GCLK),
+        .araddr(araddr),
+        .arlen(arlen),
+        .arvalid(arvalid),
+        .arready(arready),
+        .rdata(rdata),
+        .rresp(rresp),
+        .rlast(rlast),
+        .rvalid(rvalid),
+        .rready(rready)
+    );
+
+    integer errors = 0;
+
+    initial begin: fill
+        integer i;
+        for (i = 0; i < 4096; i = i + 1)
+            memory.mem[i] = { i[15:0], ~i[15:0] };
+    end
+
+    // Pops the FIFO at the pace of roughly one word per pop_period cycles,
+    // the way the SPI side drains it, and compares against the memory.
+    task receive;
+        input [31:0] addr;
+        input integer words;
+        input integer pop_period;
+        integer i;
+        reg [31:0] expected;
+        begin
+            for (i = 0; i < words; i = i + 1) begin
+                wait(!is_fifo_empty);
+                @(negedge GCLK);
+                expected = memory.mem[(addr - 32'h0010_0000) / 4 + i];
+                if (fifo_dout !== expected) begin
+                    $display("%t: ERROR: word %0d is %h, expected %h",
+                        $time, i, fifo_dout, expected);
+                    errors = errors + 1;
+                end
+                fifo_rd = 1;
+                @(negedge GCLK);
+                fifo_rd = 0;
+                repeat(pop_period) @(negedge GCLK);
+            end
+        end
+    endtask
+
+    task start;
+        input [31:0] addr;
+        input [31:0] bytes;
+        begin
+            @(negedge GCLK);
+            start_addr = addr;
+            length = bytes;
+            should_start = 1;
+            @(negedge GCLK);
+            should_start = 0;
+        end
+    endtask
+
+    initial begin: main
+        integer cycles;
+
+        wait(resetn);
+
+        // A whole frame straddling the 4KB page at 0x101000, drained slowly
+        // enough for the FIFO to fill up.
+        start(32'h0010_0F40, FRAME_BYTES);
+        receive(32'h0010_0F40, FRAME_BYTES / 4, 40);
+        wait(!is_busy);
+
+        // A whole frame drained as fast as possible, report the cycles spent.
+        cycles = 0;
+        start(32'h0010_2000, FRAME_BYTES);
+        fork
+            receive(32'h0010_2000, FRAME_BYTES / 4, 0);
+            while (is_busy || !is_fifo_empty) begin
+                @(posedge GCLK);
+                cycles = cycles + 1;
+            end
+        join
+        $display("%0d bytes fetched in %0d cycles", FRAME_BYTES, cycles);
+
+        // A single word.
+        start(32'h0010_3FFC, 4);
+        receive(32'h0010_3FFC, 1, 0);
+        wait(!is_busy);
+
+        // An abort lets the outstanding burst complete and then stops.
+        start(32'h0010_0000, FRAME_BYTES);
+        repeat(20) @(posedge GCLK);
+        should_abort = 1;
+        wait(!is_busy);
+        should_abort = 0;
+        if (fifo_space < FIFO_DEPTH - 16 || has_failed) begin
+            $display("%t: ERROR: abort went on past the first burst", $time);
+            errors = errors + 1;
+        end
+
+        errors = errors + memory.errors;
+        if (errors == 0)
+            $display("PASSED");
+        else
+            $display("FAILED with %0d errors", errors);
+        $finish;
+    end
+
+endmodule
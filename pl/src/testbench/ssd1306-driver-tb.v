@@ -1,5 +1,12 @@
 `include "../verilog/timescale.vh"
 
+// Powers the display on, sends a command through din and then a burst of data
+// words through the FIFO, a word at a time and streamed, reporting the share
+// of the time that SCLK spent clocking the bits out for both. Then puts the
+// display to sleep and resumes it, a single Display OFF/ON each with VDD and
+// VCC left alone. Then uploads a script with a loop, a jump and a wait, runs
+// it with a FIFO entry and checks the data bytes it sends, and puts the
+// display to sleep again. Powers off last, which has to end the sleep.
 module ssd1306_driver_tb;
 
     reg GCLK = 1;
@@ -14,6 +21,10 @@ module ssd1306_driver_tb;
         reset = 1;
     end
 
+    localparam SCLK_DIVIDER = 20;
+    localparam WORDS_NB = 32;
+    localparam CLK_PERIOD = 10;
+
     wire ssd1306_vdd;
     wire ssd1306_vcc;
     wire ssd1306_reset;
@@ -21,16 +32,77 @@ module ssd1306_driver_tb;
     wire ssd1306_dc;
     wire ssd1306_sdin;
     wire ssd1306_sclk;
-    reg should_turn_power_on;
+    reg should_turn_power_on = 0;
+    reg should_sleep = 0;
+    reg should_stream = 0;
     reg should_send_din;
     reg [`DATA_WIDTH - 1:0] din = 0;
     reg is_din_data = 0;
-    ssd1306_driver uut (
+    reg fifo_wr = 0;
+    reg fifo_w_is_u8 = 0;
+    reg fifo_w_is_data = 1;
+    reg [`DATA_WIDTH - 1:0] fifo_wdata = 0;
+    reg script_wr = 0;
+    reg [7:0] script_waddr = 0;
+    reg [15:0] script_wdata = 0;
+    wire fifo_rd;
+    wire [`DATA_WIDTH + 1:0] fifo_dout;
+    wire is_fifo_empty;
+    wire is_idle;
+    wire is_busy;
+    wire is_powered_on;
+    wire is_asleep;
+    wire is_running_rom;
+    wire is_word_taken;
+    wire is_word_u8;
+    wire is_word_data;
+
+    // The entries are 32-bit data words, as the DMA pushes them, but for the
+    // script runs, which are neither data nor u8.
+    fifo #(
+        .WIDTH(`DATA_WIDTH + 2),
+        .DEPTH(64)
+    ) fifo_inst (
+        .clk(GCLK),
+        .clear(!should_turn_power_on),
+        .wr(fifo_wr),
+        .din({ fifo_w_is_u8, fifo_w_is_data, fifo_wdata }),
+        .rd(fifo_rd),
+        .dout(fifo_dout),
+        .is_empty(is_fifo_empty),
+        .is_full(),
+        .level(),
+        .space()
+    );
+
+    ssd1306_driver #(
+        .SCLK_DIVIDER(SCLK_DIVIDER)
+    ) uut (
         .clk(GCLK),
+        .sclk_divider(8'd0),
         .should_turn_power_on(should_turn_power_on),
+        .should_sleep(should_sleep),
+        .should_stream(should_stream),
         .should_send_din(should_send_din),
+        .is_din_u8(1'b1),
         .is_din_data(is_din_data),
         .din(din),
+        .is_fifo_empty(is_fifo_empty),
+        .is_fifo_din_u8(fifo_dout[`DATA_WIDTH + 1]),
+        .is_fifo_din_data(fifo_dout[`DATA_WIDTH]),
+        .fifo_din(fifo_dout[`DATA_WIDTH - 1:0]),
+        .script_wr(script_wr),
+        .script_waddr(script_waddr),
+        .script_wdata(script_wdata),
+        .fifo_rd(fifo_rd),
+        .is_busy(is_busy),
+        .is_idle(is_idle),
+        .is_powered_on(is_powered_on),
+        .is_asleep(is_asleep),
+        .is_running_rom(is_running_rom),
+        .is_word_taken(is_word_taken),
+        .is_word_u8(is_word_u8),
+        .is_word_data(is_word_data),
         .ssd1306_vdd(ssd1306_vdd),
         .ssd1306_reset(ssd1306_reset),
         .ssd1306_vcc(ssd1306_vcc),
@@ -40,6 +112,166 @@ module ssd1306_driver_tb;
         .ssd1306_sclk(ssd1306_sclk)
     );
 
+    // The receiving end, the data bits are sampled on the rising edges of
+    // sclk and every word must be the next one of the burst, but while a
+    // script runs, which sends bytes.
+    integer errors = 0;
+    integer bits_nb = 0;
+    integer words_nb = 0;
+    reg is_running_script = 0;
+    reg [`DATA_WIDTH - 1:0] received = 0;
+    always @(posedge ssd1306_sclk)
+        if (!ssd1306_cs && ssd1306_dc && !is_running_script) begin
+            received = { received[`DATA_WIDTH - 2:0], ssd1306_sdin };
+            bits_nb = bits_nb + 1;
+            if (bits_nb % `DATA_WIDTH == 0) begin
+                if (received !== (32'hC0DE0000 | words_nb % WORDS_NB)) begin
+                    $display("%t: ERROR: word %0d is %h",
+                        $time, words_nb, received);
+                    errors = errors + 1;
+                end
+                words_nb = words_nb + 1;
+            end
+        end
+
+    // The data bytes of the script, up to 8 of them.
+    integer script_bits_nb = 0;
+    reg [63:0] script_bytes = 0;
+    always @(posedge ssd1306_sclk)
+        if (!ssd1306_cs && ssd1306_dc && is_running_script) begin
+            script_bytes = { script_bytes[62:0], ssd1306_sdin };
+            script_bits_nb = script_bits_nb + 1;
+        end
+
+    // The commands, a byte each, the last one of them.
+    integer command_bits_nb = 0;
+    integer commands_nb = 0;
+    reg [7:0] command = 0;
+    always @(posedge ssd1306_sclk)
+        if (!ssd1306_cs && !ssd1306_dc) begin
+            command = { command[6:0], ssd1306_sdin };
+            command_bits_nb = command_bits_nb + 1;
+            if (command_bits_nb % 8 == 0)
+                commands_nb = commands_nb + 1;
+        end
+
+    // Sleeping must not touch the supplies.
+    integer power_changes_nb = 0;
+    always @(ssd1306_vdd or ssd1306_vcc)
+        power_changes_nb = power_changes_nb + 1;
+
+    task expect_command;
+        input [7:0] expected;
+        input integer first_nb;
+        begin
+            if (commands_nb != first_nb + 1 || command !== expected) begin
+                $display("%t: ERROR: %0d commands, the last %h, expected %h alone",
+                    $time, commands_nb - first_nb, command, expected);
+                errors = errors + 1;
+            end
+        end
+    endtask
+
+    task sleep_and_resume;
+        integer first_nb;
+        integer first_changes_nb;
+        begin
+            first_changes_nb = power_changes_nb;
+
+            first_nb = commands_nb;
+            should_sleep = 1;
+            wait(is_asleep);
+            wait(is_idle);
+            expect_command(8'hAE, first_nb);
+
+            first_nb = commands_nb;
+            should_sleep = 0;
+            wait(!is_asleep);
+            wait(is_idle);
+            expect_command(8'hAF, first_nb);
+
+            if (power_changes_nb != first_changes_nb) begin
+                $display("%t: ERROR: VDD/VCC changed while sleeping", $time);
+                errors = errors + 1;
+            end
+            $display("sleep and resume: a command each");
+        end
+    endtask
+
+    task write_script_word;
+        input [7:0] address;
+        input [15:0] word;
+        begin
+            script_waddr = address;
+            script_wdata = word;
+            script_wr = 1;
+            @(negedge GCLK);
+            script_wr = 0;
+        end
+    endtask
+
+    // 0x5A three times over in a loop, a jump over 0xFF, a 1ms wait, 0xA5.
+    localparam SCRIPT_ADDR = 16;
+    localparam [31:0] SCRIPT_BYTES = 32'h5A5A5AA5;
+
+    task run_script;
+        begin
+            @(negedge GCLK);
+            write_script_word(SCRIPT_ADDR + 0, 16'hA803); // set the loop to 3
+            write_script_word(SCRIPT_ADDR + 1, 16'hA05A); // data 0x5A
+            write_script_word(SCRIPT_ADDR + 2, 16'hAC00 | (SCRIPT_ADDR + 1)); // loop
+            write_script_word(SCRIPT_ADDR + 3, 16'hA400 | (SCRIPT_ADDR + 5)); // jump
+            write_script_word(SCRIPT_ADDR + 4, 16'hA0FF); // data 0xFF, jumped over
+            write_script_word(SCRIPT_ADDR + 5, 16'hB001); // wait 1ms
+            write_script_word(SCRIPT_ADDR + 6, 16'hA0A5); // data 0xA5
+            write_script_word(SCRIPT_ADDR + 7, 16'hBC00); // end
+
+            is_running_script = 1;
+            script_bits_nb = 0;
+            fifo_w_is_u8 = 0;
+            fifo_w_is_data = 0;
+            fifo_wdata = SCRIPT_ADDR;
+            fifo_wr = 1;
+            @(negedge GCLK);
+            fifo_wr = 0;
+            fifo_w_is_data = 1;
+            @(negedge GCLK);
+            wait(is_fifo_empty && is_idle && !is_running_rom);
+            is_running_script = 0;
+
+            if (script_bits_nb != 32 || script_bytes[31:0] !== SCRIPT_BYTES) begin
+                $display("%t: ERROR: the script sent %0d bits, %h, expected %h",
+                    $time, script_bits_nb, script_bytes[31:0], SCRIPT_BYTES);
+                errors = errors + 1;
+            end
+            $display("script: %0d data bytes", script_bits_nb / 8);
+        end
+    endtask
+
+    task burst;
+        input streaming;
+        integer i;
+        integer start_time;
+        integer cycles;
+        begin
+            should_stream = streaming;
+            @(negedge GCLK);
+            start_time = $time;
+            for (i = 0; i < WORDS_NB; i = i + 1) begin
+                fifo_wdata = 32'hC0DE0000 | i;
+                fifo_wr = 1;
+                @(negedge GCLK);
+            end
+            fifo_wr = 0;
+            wait(is_fifo_empty && is_idle);
+
+            cycles = ($time - start_time) / CLK_PERIOD;
+            $display("%0s: %0d words in %0d cycles, SCLK utilization %0d%%",
+                streaming ? "streaming" : "a word at a time", WORDS_NB, cycles,
+                WORDS_NB * `DATA_WIDTH * (SCLK_DIVIDER + 1) * 100 / cycles);
+        end
+    endtask
+
     initial begin
         wait(reset);
         wait(!reset);
@@ -58,12 +290,40 @@ module ssd1306_driver_tb;
         repeat(1) @(posedge ssd1306_cs);
         should_send_din = 0;
 
+        // The ROM is done once the driver is idle.
+        wait(is_idle);
+        burst(0);
+        burst(1);
+        if (words_nb != 2 * WORDS_NB) begin
+            $display("ERROR: %0d words received, expected %0d",
+                words_nb, 2 * WORDS_NB);
+            errors = errors + 1;
+        end
+
+        sleep_and_resume;
+        run_script;
+
+        // Power off straight from sleep.
+        should_sleep = 1;
+        wait(is_asleep);
+        wait(is_idle);
+
         #(100) //100ns
 
         should_turn_power_on = 0;
         wait(ssd1306_vdd);
+        wait(!is_powered_on);
         #(10*100);
+        if (is_asleep) begin
+            $display("ERROR: still asleep after the power off");
+            errors = errors + 1;
+        end
+        should_sleep = 0;
 
+        if (errors == 0)
+            $display("PASSED");
+        else
+            $display("FAILED with %0d errors", errors);
         $finish;
     end
 
@@ -0,0 +1,84 @@
+#ifndef BUS_ADDRESS_MAP_HPP
+#define BUS_ADDRESS_MAP_HPP
+
+#include <assert.h>
+#include <vector>
+#include "xil_types.h"
+
+/*
+ * The 32-bit addresses that the DMA of the IP is given for the buffers of the
+ * host, whose pointers are wider. Every buffer flushed gets a window of the
+ * 32-bit space of its own, unless it is in one already, so the address of a
+ * pointer is only known once the memory it points at has been flushed.
+ *
+ * The windows are laid out one after another from BASE, never reused; the
+ * host programs flush a handful of buffers over and over.
+ */
+class BusAddressMap {
+
+public:
+    static const u32 BASE = 0x10000000;
+
+    BusAddressMap():
+        nextAddress(BASE) {
+    }
+
+    inline
+    u32 map(const void *p, u32 size) {
+        /* Return the address of p, giving [p, p + size) a window if needed. */
+        const Window *window = find(p, size);
+        if (window)
+            return window->address + (u32)((const u8 *)p - window->p);
+
+        /* Out of 32-bit addresses. */
+        assert((u64)nextAddress + size <= (u64)0xFFFFFFFF + 1);
+
+        Window w;
+        w.p = (const u8 *)p;
+        w.size = size;
+        w.address = nextAddress;
+        windows.push_back(w);
+        nextAddress += (size + 3) & ~(u32)3;
+        return w.address;
+    }
+
+    inline
+    u32 toBusAddress(const void *p) const {
+        /* The address of p, which must have been flushed. */
+        const Window *window = find(p, 1);
+        assert(window);
+        return window->address + (u32)((const u8 *)p - window->p);
+    }
+
+private:
+    struct Window {
+        const u8    *p;
+            /* The start of the buffer on the host. */
+
+        u32         size;
+            /* Number of bytes of the buffer. */
+
+        u32         address;
+            /* The bus address of p. */
+    };
+
+    inline
+    const Window *find(const void *p, u32 size) const {
+        /* The window that [p, p + size) is in, the latest one first. */
+        const u8 *first = (const u8 *)p;
+        for (size_t i = windows.size(); i-- > 0;) {
+            const Window *w = &windows[i];
+            if (first >= w->p && first + size <= w->p + w->size)
+                return w;
+        }
+        return 0;
+    }
+
+    std::vector<Window> windows;
+        /* The buffers flushed so far, in the order they were first seen. */
+
+    u32             nextAddress;
+        /* The bus address that the next window starts at. */
+};
+
+#endif // BUS_ADDRESS_MAP_HPP
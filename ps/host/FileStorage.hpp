@@ -0,0 +1,30 @@
+#ifndef FILE_STORAGE_HPP
+#define FILE_STORAGE_HPP
+
+#include <stdio.h>
+#include <stddef.h>
+#include "xil_types.h"
+
+/*
+ * FileStorage is the Storage of FrameStream for a file on the host, e.g.
+ * a container written by utils/framepack -c. The file stays open as long as
+ * the FileStorage, or its copy in a FrameStream, is used.
+ */
+struct FileStorage {
+
+    FileStorage(FILE *fp = 0):
+        file(fp) {
+    }
+
+    inline
+    bool read(u32 offset, void *out, size_t nb) const {
+        return file != 0 &&
+            fseek(file, offset, SEEK_SET) == 0 &&
+            fread(out, 1, nb, file) == nb;
+    }
+
+    FILE            *file;
+        /* The file opened for reading. */
+};
+
+#endif // FILE_STORAGE_HPP
@@ -0,0 +1,132 @@
+#ifndef RECORDING_BUS_HPP
+#define RECORDING_BUS_HPP
+
+#include <chrono>
+#include <vector>
+#include "xil_types.h"
+#include "ssd1306_driver.h"
+#include "BusAddressMap.hpp"
+#include "Ssd1306Model.hpp"
+
+/*
+ * Register access of an Ssd1306 driver on the host. Every access is recorded
+ * along with the time it took place at.
+ *
+ * The registers are modelled as an idle driver with an empty TX FIFO: the
+ * status (reg2), the interrupt status (reg9) and the overflows of the perf
+ * counters (reg10) read as 0, the FIFO status (reg5) reads as FIFO_DEPTH
+ * entries of space, the rest read back what was last written.
+ *
+ * With a panel() set, the register writes and the flushed buffers go to it as
+ * well, so what the driver would show can be checked. The buffers are known to
+ * the DMA by the 32-bit addresses of BusAddressMap.
+ */
+struct RecordingBus {
+
+    static const u32 FIFO_DEPTH = 256;
+    static const u32 REGISTERS_NB = 32;
+
+    struct Access {
+        u64         time;
+            /* Nanoseconds since the first access. */
+
+        bool        isWrite;
+            /* Whether the access was a write (or a read). */
+
+        u32         offset;
+            /* Offset of the accessed register. */
+
+        u32         value;
+            /* The value written or read. */
+    };
+
+    static inline
+    u32 read(u32 offset) {
+        u32 value;
+        switch (offset) {
+        case SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET:
+        case SSD1306_DRIVER_S00_AXI_SLV_REG9_OFFSET:
+        case SSD1306_DRIVER_S00_AXI_SLV_REG10_OFFSET:
+            value = 0;
+            break;
+        case SSD1306_DRIVER_S00_AXI_SLV_REG5_OFFSET:
+            value = FIFO_DEPTH << 16;
+            break;
+        default:
+            value = registers()[(offset / 4) % REGISTERS_NB];
+            break;
+        }
+        record(false, offset, value);
+        return value;
+    }
+
+    static inline
+    void write(u32 offset, u32 value) {
+        registers()[(offset / 4) % REGISTERS_NB] = value;
+        record(true, offset, value);
+        if (panel())
+            panel()->writeRegister(offset, value);
+    }
+
+    static inline
+    u32 toBusAddress(const void *p) {
+        return addressMap().toBusAddress(p);
+    }
+
+    static inline
+    void flushForDevice(const void *p, u32 size) {
+        u32 address = addressMap().map(p, size);
+        if (panel())
+            panel()->flush(address, p, size);
+    }
+
+    static inline
+    Ssd1306Model *&panel() {
+        /* The panel behind the driver, none by default. */
+        static Ssd1306Model *model = 0;
+        return model;
+    }
+
+    static inline
+    std::vector<Access> &accesses() {
+        /* The recorded accesses, in order. */
+        static std::vector<Access> log;
+        return log;
+    }
+
+    static inline
+    void clear() {
+        accesses().clear();
+    }
+
+private:
+    static inline
+    BusAddressMap &addressMap() {
+        static BusAddressMap map;
+        return map;
+    }
+
+    static inline
+    u32 *registers() {
+        static u32 values[REGISTERS_NB];
+        return values;
+    }
+
+    static inline
+    void record(bool isWrite, u32 offset, u32 value) {
+        static const std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+
+        Access access;
+        access.time =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start
+            ).count();
+        access.isWrite = isWrite;
+        access.offset = offset;
+        access.value = value;
+        accesses().push_back(access);
+    }
+};
+
+#endif // RECORDING_BUS_HPP
@@ -0,0 +1,666 @@
+#ifndef SSD1306_MODEL_HPP
+#define SSD1306_MODEL_HPP
+
+#include <stdio.h>
+#include <string.h>
+#include <unordered_map>
+#include "xil_types.h"
+#include "ssd1306_driver.h"
+
+/*
+ * A functional model of the SSD1306 controller behind a 128x32 panel, for
+ * checking on the host what the panel would show.
+ *
+ * It takes the command/data byte stream from any of:
+ *
+ *  - write(), a byte at a time along with the level of D/C#,
+ *  - writeRegister(), the register writes of the ssd1306_driver IP, e.g. from
+ *    RecordingBus, the DMA fetching from what was given to flush(),
+ *  - sampleSpi(), the levels of the SPI pins, e.g. every cycle of the RTL.
+ *
+ * GDDRAM is 8 pages of 128 columns. The model implements the horizontal,
+ * vertical and page addressing modes with their column/page windows, the
+ * display start line and offset, the multiplex ratio, the segment and COM
+ * remaps, inverse and entire display on, and scrolling, which moves GDDRAM
+ * (the datasheet leaves it undefined afterwards) by advance() display frames.
+ * The commands of the charge pump, the timing and such are taken in along with
+ * their arguments and have no effect. The scripts of the IP are run as their
+ * runs are written, waits aside, and so are the sequences of its ROM, which
+ * the Makefile takes from power_on_off_sequence.coe of the IP into
+ * power_on_off_sequence.inc.
+ *
+ * In the images, x grows to the right and y downwards, a lit pixel is 1, i.e.
+ * black in a PBM.
+ */
+class Ssd1306Model {
+
+public:
+    static const int WIDTH = 128;
+    static const int GDDRAM_PAGES_NB = 8;
+    static const int GDDRAM_ROWS_NB = GDDRAM_PAGES_NB * 8;
+    static const int PANEL_ROWS_NB = 32;
+    static const int SCRIPT_WORDS_NB = 256;
+    static const int SCRIPT_STEPS_MAX = 1 << 20;
+
+    enum AddressingMode {
+        Horizontal = 0,
+        Vertical = 1,
+        Page = 2,
+    };
+
+    Ssd1306Model():
+        commandsNb(0),
+        dataNb(0),
+        control(0),
+        din(0),
+        dmaAddr(0),
+        spiBitsNb(0),
+        spiByte(0),
+        wasSclkHigh(true) {
+        for (int i = 0; i < SCRIPT_WORDS_NB; ++i)
+            script[i] = 0xBC00;
+        reset();
+    }
+
+    inline
+    void reset() {
+        /* The state of the panel after RES#, as per the datasheet. */
+        memset(gddram, 0, sizeof(gddram));
+        mode = Page;
+        firstColumn = 0;
+        lastColumn = WIDTH - 1;
+        firstPage = 0;
+        lastPage = GDDRAM_PAGES_NB - 1;
+        column = 0;
+        page = 0;
+        startLine = 0;
+        displayOffset = 0;
+        multiplexRatio = GDDRAM_ROWS_NB - 1;
+        isSegmentRemapped = false;
+        isComRemapped = false;
+        isInverse = false;
+        isEntireOn = false;
+        isOn = false;
+        scroll.isActive = false;
+        scroll.isVertical = false;
+        scroll.isLeft = false;
+        scroll.firstPage = 0;
+        scroll.lastPage = 0;
+        scroll.interval = 5;
+        scroll.verticalOffset = 0;
+        scroll.fixedRowsNb = 0;
+        scroll.scrolledRowsNb = GDDRAM_ROWS_NB;
+        scroll.framesNb = 0;
+        scroll.rowsNb = 0;
+        cmdNb = 0;
+        argsNb = 0;
+    }
+
+    inline
+    void write(bool isData, u8 byte) {
+        /* A byte as the panel receives it, D/C# high for data. */
+        if (isData) {
+            ++dataNb;
+            writeData(byte);
+            return;
+        }
+
+        ++commandsNb;
+        if (argsNb > 0) {
+            args[cmdNb - argsNb] = byte;
+            if (--argsNb == 0)
+                execute();
+            return;
+        }
+
+        cmd = byte;
+        cmdNb = argsNbOf(byte);
+        argsNb = cmdNb;
+        if (argsNb == 0)
+            execute();
+    }
+
+    inline
+    void writeWord(bool isData, bool isU8, u32 word) {
+        /* A word of the IP: a byte (commands always), or 4 bytes MSB first. */
+        if (!isData || isU8) {
+            write(isData, word & 0xFF);
+            return;
+        }
+        for (int i = 3; i >= 0; --i)
+            write(true, (word >> (8 * i)) & 0xFF);
+    }
+
+    inline
+    void writeRegister(u32 offset, u32 value) {
+        /*
+         * A register write of the ssd1306_driver IP, see Ssd1306.hpp for the
+         * layout. The panel gets nothing while should_turn_power_on is clear,
+         * a power on starts it over from reset, and the commands of the ROM
+         * are played as the IP does, so are Display OFF/ON of should_sleep.
+         */
+        switch (offset) {
+        case SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET: {
+            u32 rising = value & ~control;
+            u32 falling = control & ~value;
+            control = value;
+            if (rising & 1)
+                powerOn();
+            if (falling & 1)
+                playRom(ROM_POWER_OFF_BASE, ROM_POWER_OFF_MAX);
+            if ((control & 1) && (rising & 0x21) && (control & 0x20))
+                playRom(ROM_SLEEP_BASE, ROM_SLEEP_MAX);
+            if ((control & 1) && !(rising & 1) && (falling & 0x20))
+                playRom(ROM_RESUME_BASE, ROM_RESUME_MAX);
+            if ((rising & 2) && (control & 1))
+                writeWord(control & 4, control & 8, din);
+            break;
+        }
+
+        case SSD1306_DRIVER_S00_AXI_SLV_REG1_OFFSET:
+            din = value;
+            break;
+
+        case SSD1306_DRIVER_S00_AXI_SLV_REG4_OFFSET:
+            if (control & 1)
+                writeWord(control & 4, control & 8, value);
+            break;
+
+        case SSD1306_DRIVER_S00_AXI_SLV_REG6_OFFSET:
+            dmaAddr = value;
+            break;
+
+        case SSD1306_DRIVER_S00_AXI_SLV_REG7_OFFSET:
+            if (control & 1) {
+                for (u32 i = 0; i < value / 4; ++i)
+                    writeWord(true, false, memory[dmaAddr + 4 * i]);
+            }
+            break;
+
+        case SSD1306_DRIVER_S00_AXI_SLV_REG18_OFFSET:
+            script[(value >> 16) & 0xFF] = value & 0xFFFF;
+            break;
+
+        case SSD1306_DRIVER_S00_AXI_SLV_REG19_OFFSET:
+            if (control & 1)
+                runScript(value & 0xFF);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    inline
+    void flush(u32 addr, const void *p, u32 size) {
+        /* What the DMA of the IP reads at addr is what was last flushed. */
+        const u32 *words = (const u32 *)p;
+        for (u32 i = 0; i < size / 4; ++i)
+            memory[addr + 4 * i] = words[i];
+    }
+
+    inline
+    void sampleSpi(bool isCsHigh, bool isDcHigh, bool isSclkHigh, bool isMosiHigh) {
+        /*
+         * The levels of the pins, sampled often enough to catch every edge of
+         * sclk. mosi is shifted in on the rising edges, MSB first, D/C# is
+         * taken with the last bit of a byte.
+         */
+        if (isCsHigh) {
+            spiBitsNb = 0;
+        }
+        else if (isSclkHigh && !wasSclkHigh) {
+            spiByte = (spiByte << 1) | isMosiHigh;
+            if (++spiBitsNb == 8) {
+                write(isDcHigh, spiByte);
+                spiBitsNb = 0;
+            }
+        }
+        wasSclkHigh = isSclkHigh;
+    }
+
+    inline
+    void advance(int framesNb) {
+        /* Let framesNb display frames go by, which is what scrolling counts. */
+        if (!scroll.isActive)
+            return;
+
+        static const int intervals[] = { 5, 64, 128, 256, 3, 4, 25, 2 };
+        scroll.framesNb += framesNb;
+        while (scroll.framesNb >= intervals[scroll.interval & 7]) {
+            scroll.framesNb -= intervals[scroll.interval & 7];
+            step();
+        }
+    }
+
+    inline
+    bool getGddramPixel(int x, int row) const {
+        return (gddram[row / 8][x] >> (row % 8)) & 1;
+    }
+
+    inline
+    bool getPixel(int x, int y) const {
+        /* The pixel of the panel, as lit (or not) by the controller. */
+        if (!isOn || y > multiplexRatio)
+            return false;
+        if (isEntireOn)
+            return true;
+
+        int com = isComRemapped ? multiplexRatio - y : y;
+        int row = (com + displayOffset) % GDDRAM_ROWS_NB;
+        if (scroll.isActive && scroll.isVertical &&
+                row >= scroll.fixedRowsNb &&
+                row < scroll.fixedRowsNb + scroll.scrolledRowsNb) {
+            row = scroll.fixedRowsNb +
+                (row - scroll.fixedRowsNb + scroll.rowsNb) % scroll.scrolledRowsNb;
+        }
+        row = (row + startLine) % GDDRAM_ROWS_NB;
+
+        int c = isSegmentRemapped ? WIDTH - 1 - x : x;
+        return getGddramPixel(c, row) != isInverse;
+    }
+
+    inline
+    void getImage(u8 pixels[PANEL_ROWS_NB][WIDTH]) const {
+        for (int y = 0; y < PANEL_ROWS_NB; ++y)
+            for (int x = 0; x < WIDTH; ++x)
+                pixels[y][x] = getPixel(x, y);
+    }
+
+    inline
+    bool writePbm(FILE *fp, bool isGddram = false) const {
+        /* The panel (or the whole of GDDRAM) as a raw PBM. */
+        int height = isGddram ? GDDRAM_ROWS_NB : PANEL_ROWS_NB;
+        fprintf(fp, "P4\n%d %d\n", WIDTH, height);
+        for (int y = 0; y < height; ++y) {
+            u8 bytes[WIDTH / 8];
+            memset(bytes, 0, sizeof(bytes));
+            for (int x = 0; x < WIDTH; ++x) {
+                bool isLit = isGddram ? getGddramPixel(x, y) : getPixel(x, y);
+                bytes[x / 8] |= isLit << (7 - x % 8);
+            }
+            if (fwrite(bytes, sizeof(bytes), 1, fp) != 1)
+                return false;
+        }
+        return true;
+    }
+
+    inline
+    bool isDisplayOn() const {
+        /* Whether the panel is lit, i.e. the last of AEh/AFh was AFh. */
+        return isOn;
+    }
+
+    inline
+    const u8 *getGddram() const {
+        /* The pages, 128 bytes each, bit k of a byte is row page * 8 + k. */
+        return &gddram[0][0];
+    }
+
+    inline
+    u64 getCommandsNb() const {
+        /* Number of command bytes received, arguments included. */
+        return commandsNb;
+    }
+
+    inline
+    u64 getDataNb() const {
+        /* Number of data bytes received. */
+        return dataNb;
+    }
+
+private:
+    /* The sequences in the ROM, the IP_*_BASE/MAX of ssd1306-driver.v. */
+    static const int ROM_POWER_ON_BASE = 0;
+    static const int ROM_POWER_ON_MAX = 21;
+    static const int ROM_POWER_OFF_BASE = ROM_POWER_ON_MAX;
+    static const int ROM_POWER_OFF_MAX = ROM_POWER_OFF_BASE + 3;
+    static const int ROM_SLEEP_BASE = ROM_POWER_OFF_MAX;
+    static const int ROM_SLEEP_MAX = ROM_SLEEP_BASE + 1;
+    static const int ROM_RESUME_BASE = ROM_SLEEP_MAX;
+    static const int ROM_RESUME_MAX = ROM_RESUME_BASE + 1;
+
+    static inline
+    int argsNbOf(u8 cmd) {
+        switch (cmd) {
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 1;
+        case 0x21: case 0x22: case 0xA3:
+            return 2;
+        case 0x29: case 0x2A:
+            return 5;
+        case 0x26: case 0x27:
+            return 6;
+        default:
+            return 0;
+        }
+    }
+
+    inline
+    void execute() {
+        if (cmd <= 0x0F) {
+            column = (column & 0xF0) | cmd;
+            return;
+        }
+        if (cmd <= 0x1F) {
+            column = ((cmd & 0x07) << 4) | (column & 0x0F);
+            return;
+        }
+        if (cmd >= 0x40 && cmd <= 0x7F) {
+            startLine = cmd & 0x3F;
+            return;
+        }
+        if (cmd >= 0xB0 && cmd <= 0xB7) {
+            page = cmd & 0x07;
+            return;
+        }
+
+        switch (cmd) {
+        case 0x20:
+            mode = (AddressingMode)(args[0] & 0x03);
+            break;
+        case 0x21:
+            firstColumn = column = args[0] & 0x7F;
+            lastColumn = args[1] & 0x7F;
+            break;
+        case 0x22:
+            firstPage = page = args[0] & 0x07;
+            lastPage = args[1] & 0x07;
+            break;
+        case 0x26:
+        case 0x27:
+            scroll.isVertical = false;
+            scroll.isLeft = cmd == 0x27;
+            scroll.firstPage = args[1] & 0x07;
+            scroll.interval = args[2] & 0x07;
+            scroll.lastPage = args[3] & 0x07;
+            break;
+        case 0x29:
+        case 0x2A:
+            scroll.isVertical = true;
+            scroll.isLeft = cmd == 0x2A;
+            scroll.firstPage = args[1] & 0x07;
+            scroll.interval = args[2] & 0x07;
+            scroll.lastPage = args[3] & 0x07;
+            scroll.verticalOffset = args[4] & 0x3F;
+            break;
+        case 0x2E:
+            scroll.isActive = false;
+            break;
+        case 0x2F:
+            scroll.isActive = true;
+            scroll.framesNb = 0;
+            scroll.rowsNb = 0;
+            break;
+        case 0xA0:
+        case 0xA1:
+            isSegmentRemapped = cmd == 0xA1;
+            break;
+        case 0xA3:
+            scroll.fixedRowsNb = args[0] & 0x3F;
+            scroll.scrolledRowsNb = args[1] & 0x7F;
+            if (scroll.scrolledRowsNb == 0)
+                scroll.scrolledRowsNb = 1;
+            break;
+        case 0xA4:
+        case 0xA5:
+            isEntireOn = cmd == 0xA5;
+            break;
+        case 0xA6:
+        case 0xA7:
+            isInverse = cmd == 0xA7;
+            break;
+        case 0xA8:
+            if ((args[0] & 0x3F) >= 15)
+                multiplexRatio = args[0] & 0x3F;
+            break;
+        case 0xAE:
+        case 0xAF:
+            isOn = cmd == 0xAF;
+            break;
+        case 0xC0:
+        case 0xC8:
+            isComRemapped = cmd == 0xC8;
+            break;
+        case 0xD3:
+            displayOffset = args[0] & 0x3F;
+            break;
+        default:
+            break;
+        }
+    }
+
+    inline
+    void writeData(u8 byte) {
+        gddram[page][column] = byte;
+
+        switch (mode) {
+        case Horizontal:
+            if (column < lastColumn) {
+                ++column;
+                break;
+            }
+            column = firstColumn;
+            page = page < lastPage ? page + 1 : firstPage;
+            break;
+
+        case Vertical:
+            if (page < lastPage) {
+                ++page;
+                break;
+            }
+            page = firstPage;
+            column = column < lastColumn ? column + 1 : firstColumn;
+            break;
+
+        default:
+            /* The page stays, the column wraps around. */
+            column = (column + 1) % WIDTH;
+            break;
+        }
+    }
+
+    inline
+    void step() {
+        /* A column of the scrolled pages, plus the rows of vertical scrolling. */
+        for (int p = scroll.firstPage; p <= scroll.lastPage && p < GDDRAM_PAGES_NB; ++p) {
+            u8 *columns = gddram[p];
+            if (scroll.isLeft) {
+                u8 first = columns[0];
+                memmove(columns, columns + 1, WIDTH - 1);
+                columns[WIDTH - 1] = first;
+            }
+            else {
+                u8 last = columns[WIDTH - 1];
+                memmove(columns + 1, columns, WIDTH - 1);
+                columns[0] = last;
+            }
+        }
+        if (scroll.isVertical)
+            scroll.rowsNb = (scroll.rowsNb + scroll.verticalOffset) % scroll.scrolledRowsNb;
+    }
+
+    inline
+    void runScript(u8 address) {
+        /*
+         * The script at address as the IP runs it, see src/ssd1306-driver.v,
+         * with RES# low resetting and VDD/VCC ignored. One that has not ended
+         * after SCRIPT_STEPS_MAX instructions is cut short.
+         */
+        u8 ip = address;
+        int loopCounter = 0;
+        for (int i = 0; i < SCRIPT_STEPS_MAX; ++i) {
+            u16 word = script[ip++];
+            switch (word >> 14) {
+            case 0:
+                write(false, word & 0xFF);
+                break;
+
+            case 2:
+                if (!(word & 0x2000)) {
+                    if (!(word & 1))
+                        reset();
+                    break;
+                }
+                switch ((word >> 10) & 0x07) {
+                case 0:
+                    write(true, word & 0xFF);
+                    break;
+                case 1:
+                    ip = word & 0xFF;
+                    break;
+                case 2:
+                    loopCounter = word & 0x3FF;
+                    break;
+                case 3:
+                    if (loopCounter > 1) {
+                        --loopCounter;
+                        ip = word & 0xFF;
+                    }
+                    else {
+                        loopCounter = 0;
+                    }
+                    break;
+                case 4:
+                    break;
+                default:
+                    return;
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+
+    inline
+    void playRom(int base, int max) {
+        /*
+         * The instructions [base, max) of the ROM of the IP, the words of
+         * power_on_off_sequence.coe, see ssd1306-driver.v: the commands are
+         * played as bytes and RES# low gives the reset state, VDD, VCC and
+         * the waits have no effect.
+         */
+        static const u16 rom[] =
+#include "power_on_off_sequence.inc"
+
+        for (int i = base; i < max && i < (int)(sizeof(rom) / sizeof(rom[0])); ++i) {
+            u16 word = rom[i];
+            if ((word >> 14) == 0)
+                write(false, word & 0xFF);
+            else if ((word >> 13) == 4 && !(word & 1))
+                reset();
+        }
+    }
+
+    inline
+    void powerOn() {
+        /* From reset, as the panel comes up with VDD. */
+        reset();
+        playRom(ROM_POWER_ON_BASE, ROM_POWER_ON_MAX);
+    }
+
+    u8              gddram[GDDRAM_PAGES_NB][WIDTH];
+        /* The display RAM. */
+
+    AddressingMode  mode;
+        /* Set with 20h. */
+
+    int             firstColumn;
+    int             lastColumn;
+        /* The column window of the horizontal/vertical modes, 21h. */
+
+    int             firstPage;
+    int             lastPage;
+        /* The page window of the horizontal/vertical modes, 22h. */
+
+    int             column;
+    int             page;
+        /* Where the next data byte goes. */
+
+    int             startLine;
+        /* The GDDRAM row on COM0, 40h-7Fh. */
+
+    int             displayOffset;
+        /* The vertical shift of COM, D3h. */
+
+    int             multiplexRatio;
+        /* Number of rows shown minus 1, A8h. */
+
+    bool            isSegmentRemapped;
+        /* Column 127 is on SEG0, A1h. */
+
+    bool            isComRemapped;
+        /* The COM scan goes upwards, C8h. */
+
+    bool            isInverse;
+        /* A7h. */
+
+    bool            isEntireOn;
+        /* A5h. */
+
+    bool            isOn;
+        /* AFh. */
+
+    struct {
+        bool        isActive;
+        bool        isVertical;
+        bool        isLeft;
+        int         firstPage;
+        int         lastPage;
+        int         interval;
+            /* The code of the interval of steps, 0-7. */
+        int         verticalOffset;
+        int         fixedRowsNb;
+        int         scrolledRowsNb;
+            /* The vertical scroll area, A3h. */
+        int         framesNb;
+            /* Frames since the last step. */
+        int         rowsNb;
+            /* The rows scrolled vertically so far. */
+    }               scroll;
+
+    u8              cmd;
+        /* The command being received. */
+
+    u8              args[6];
+        /* Its arguments. */
+
+    int             cmdNb;
+        /* Number of arguments of cmd. */
+
+    int             argsNb;
+        /* Number of arguments still to come. */
+
+    u64             commandsNb;
+    u64             dataNb;
+        /* Number of bytes received. */
+
+    u32             control;
+        /* reg0 of the IP. */
+
+    u32             din;
+        /* reg1 of the IP. */
+
+    u32             dmaAddr;
+        /* reg6 of the IP. */
+
+    std::unordered_map<u32, u32> memory;
+        /* The words flushed for the DMA, by bus address. */
+
+    u16             script[SCRIPT_WORDS_NB];
+        /* The script memory of the IP. */
+
+    int             spiBitsNb;
+        /* Bits of spiByte shifted in so far. */
+
+    u8              spiByte;
+        /* The byte being shifted in from mosi. */
+
+    bool            wasSclkHigh;
+        /* The level of sclk at the previous sample. */
+};
+
+#endif // SSD1306_MODEL_HPP
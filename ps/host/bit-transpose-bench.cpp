@@ -0,0 +1,132 @@
+/*
+ * Checks every BitTranspose path the host can run against a pixel by pixel
+ * conversion and reports how many frames per second each of them converts,
+ * for the 128x32 display and for a 128x64 one.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "BitTranspose.hpp"
+
+#define NELS(a) (sizeof(a) / sizeof(a[0]))
+
+typedef void (*ToPagesFn)(const u8 rows[], int width, int height, u8 pages[], bool isFlipped);
+
+struct Path {
+    const char  *name;
+    ToPagesFn   toPages;
+};
+
+struct Size {
+    int width;
+    int height;
+};
+
+static const int WIDTH_MAX = 128;
+static const int HEIGHT_MAX = 64;
+static const int FRAMES_NB = 200000;
+
+static void
+toPagesByPixel(const u8 rows[], int width, int height, u8 pages[], bool isFlipped)
+{
+    memset(pages, 0, width * height / 8);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int pixel = (rows[y * width / 8 + x / 8] >> (x % 8)) & 1;
+            int column = isFlipped ? width - 1 - x : x;
+            pages[y / 8 * width + column] |= pixel << (y % 8);
+        }
+    }
+}
+
+int
+main() {
+
+    static
+    Path paths[] = {
+        { "scalar", BitTranspose::toPagesScalar },
+#if defined(BIT_TRANSPOSE_HAS_SSE2)
+        { "sse2", BitTranspose::toPagesSse2 },
+#endif
+#if defined(BIT_TRANSPOSE_HAS_AVX2)
+        { "avx2", BitTranspose::toPagesAvx2 },
+#endif
+#if defined(BIT_TRANSPOSE_HAS_NEON)
+        { "neon", BitTranspose::toPagesNeon },
+#endif
+    };
+
+    static
+    Size sizes[] = {
+        { 128, 32 },
+        { 128, 64 },
+        { 136, 40 }, /* Not a multiple of the SIMD blocks, checked only. */
+    };
+
+    static u8 rows[(WIDTH_MAX + 8) * (HEIGHT_MAX + 8) / 8];
+    static u8 expected[sizeof(rows)];
+    static u8 pages[sizeof(rows)];
+    int rc = 0;
+
+    srand(1);
+    for (size_t i = 0; i < sizeof(rows); ++i)
+        rows[i] = rand();
+
+    printf("%-8s %8s %8s %14s\n", "path", "size", "flipped", "frames/s");
+    for (size_t s = 0; s < NELS(sizes); ++s) {
+        int width = sizes[s].width;
+        int height = sizes[s].height;
+        size_t size = width * height / 8;
+
+        for (int isFlipped = 0; isFlipped < 2; ++isFlipped) {
+            toPagesByPixel(rows, width, height, expected, isFlipped);
+
+            for (size_t p = 0; p < NELS(paths); ++p) {
+                memset(pages, 0xA5, sizeof(pages));
+                paths[p].toPages(rows, width, height, pages, isFlipped);
+                if (memcmp(pages, expected, size) != 0 || pages[size] != 0xA5) {
+                    fprintf(stderr, "%s: %dx%d%s differs\n",
+                        paths[p].name, width, height, isFlipped ? " flipped" : "");
+                    rc = 1;
+                }
+                if (width > WIDTH_MAX || height > HEIGHT_MAX)
+                    continue;
+
+                std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now();
+                for (int f = 0; f < FRAMES_NB; ++f) {
+                    paths[p].toPages(rows, width, height, pages, isFlipped);
+                    /* Keep the compiler from hoisting the conversion. */
+                    __asm__ __volatile__("" : : "r"(pages) : "memory");
+                }
+                double seconds =
+                    std::chrono::duration_cast<std::chrono::duration<double> >(
+                        std::chrono::steady_clock::now() - start
+                    ).count();
+
+                char sizeText[32];
+                snprintf(sizeText, sizeof(sizeText), "%dx%d", width, height);
+                printf("%-8s %8s %8s %14.0f\n",
+                    paths[p].name, sizeText, isFlipped ? "yes" : "no", FRAMES_NB / seconds);
+            }
+        }
+    }
+
+    /* The frame layout: words of 4 columns, the leftmost one in the MSB. */
+    static u32 frame[128 * 32 / 32];
+    BitTranspose::toFrame(rows, 128, 32, frame);
+    toPagesByPixel(rows, 128, 32, expected, false);
+    for (int i = 0; i < 128; ++i) {
+        u32 word =
+            ((u32)expected[4 * i] << 24) | ((u32)expected[4 * i + 1] << 16) |
+            ((u32)expected[4 * i + 2] << 8) | expected[4 * i + 3];
+        if (frame[i] != word) {
+            fprintf(stderr, "toFrame: word %d differs\n", i);
+            rc = 1;
+            break;
+        }
+    }
+
+    return rc;
+}
@@ -0,0 +1,188 @@
+/*
+ * Runs FrameRing with a producer and a consumer thread, under both policies
+ * and with either side the slower one, and checks that every frame taken is
+ * whole and newer than the one before, that no frame goes missing under
+ * Backpressure, and that the frames missing under OverwriteOldest are exactly
+ * the ones the ring says it dropped, which must leave the consumer at least
+ * MIN_TAKEN_PERCENT of them, however fast the producer drops. Reports the
+ * frames per second handed over and the stats of the ring.
+ *
+ * Usage: frame-ring-stress [frames]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include "FrameRing.hpp"
+
+#define NELS(a) (sizeof(a) / sizeof(a[0]))
+
+static const u32 SLOTS_NB = 4;
+
+typedef FrameRing<SLOTS_NB> Ring;
+
+struct Run {
+    const char      *name;
+    Ring::Policy    policy;
+    int             producerSpinsNb;
+    int             consumerSpinsNb;
+        /* The most busy loops a side does per frame, at random. */
+};
+
+static const u32 FRAMES_NB = 1000000;
+static const u32 MIN_TAKEN_PERCENT = 10;
+
+static inline u32
+getWord(u32 sequence, int i)
+{
+    /* Word i of frame sequence, every word differs, so do torn frames. */
+    return sequence ^ ((u32)i * 0x9E3779B9);
+}
+
+static inline u32
+getRandom(u32 *state)
+{
+    /* xorshift32 */
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static void
+spin(u32 *state, int spinsNb)
+{
+    if (spinsNb == 0)
+        return;
+
+    volatile int sink = 0;
+    for (int i = getRandom(state) % spinsNb; i > 0; --i)
+        sink = sink + 1;
+}
+
+static void
+produce(Ring *ring, const Run *run, u32 framesNb)
+{
+    u32 state = 0x12345678;
+    for (u32 sequence = 0; sequence < framesNb; ++sequence) {
+        /*
+         * A full ring is the consumer's turn half the time, as it would be
+         * for a producer rendering at a frame rate, even with a single core
+         * to share, the other half it drops.
+         */
+        if (ring->getQueuedNb() == SLOTS_NB && getRandom(&state) % 2)
+            std::this_thread::yield();
+
+        Ring::Slot *slot;
+        while ((slot = ring->acquire()) == 0)
+            std::this_thread::yield();
+
+        for (int i = 0; i < Ring::WORDS_NB; ++i)
+            slot->frame[i] = getWord(sequence, i);
+        slot->delay = sequence;
+        spin(&state, run->producerSpinsNb);
+        ring->publish();
+    }
+}
+
+static bool
+consume(Ring *ring, const Run *run, u32 framesNb, u32 *missingNb)
+{
+    u32 state = 0x87654321;
+    u32 last = (u32)-1;
+    *missingNb = 0;
+    while (last != framesNb - 1) {
+        const Ring::Slot *slot = ring->take();
+        if (slot == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        u32 sequence = slot->delay;
+        for (int i = 0; i < Ring::WORDS_NB; ++i) {
+            if (slot->frame[i] != getWord(sequence, i)) {
+                fprintf(stderr, "%s: frame %u is torn at word %d\n",
+                    run->name, sequence, i);
+                return false;
+            }
+        }
+        if (last != (u32)-1 && sequence <= last) {
+            fprintf(stderr, "%s: frame %u after frame %u\n",
+                run->name, sequence, last);
+            return false;
+        }
+        *missingNb += sequence - (last + 1);
+        last = sequence;
+
+        spin(&state, run->consumerSpinsNb);
+        ring->release();
+    }
+    return true;
+}
+
+int
+main(int argc, char *argv[]) {
+
+    static const Run runs[] = {
+        { "backpressure", Ring::Backpressure, 0, 0 },
+        { "backpressure/slow producer", Ring::Backpressure, 2000, 0 },
+        { "backpressure/slow consumer", Ring::Backpressure, 0, 2000 },
+        { "overwrite", Ring::OverwriteOldest, 0, 0 },
+        { "overwrite/slow producer", Ring::OverwriteOldest, 2000, 0 },
+        { "overwrite/slow consumer", Ring::OverwriteOldest, 0, 2000 },
+    };
+
+    u32 framesNb = argc > 1 ? strtoul(argv[1], 0, 0) : FRAMES_NB;
+    if (framesNb == 0) {
+        fprintf(stderr, "Usage: %s [frames]\n", argv[0]);
+        return 1;
+    }
+
+    int rc = 0;
+    printf("%-28s %10s %10s %10s %10s %10s %8s  %s\n",
+        "run", "frames/s", "published", "taken", "dropped", "rejected",
+        "max q", "queued 0..4");
+    for (size_t r = 0; r < NELS(runs); ++r) {
+        const Run *run = &runs[r];
+        static Ring ring;
+        ring = Ring(run->policy);
+
+        bool isOk = false;
+        u32 missingNb = 0;
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        std::thread consumer([&] {
+            isOk = consume(&ring, run, framesNb, &missingNb);
+        });
+        produce(&ring, run, framesNb);
+        consumer.join();
+        double s =
+            std::chrono::duration_cast<std::chrono::duration<double> >(
+                std::chrono::steady_clock::now() - start
+            ).count();
+
+        Ring::Stats stats = ring.getStats();
+        if (!isOk)
+            rc = 1;
+        if (stats.publishedNb != framesNb ||
+                stats.publishedNb != stats.takenNb + stats.droppedNb ||
+                missingNb != stats.droppedNb ||
+                (run->policy == Ring::Backpressure && stats.droppedNb != 0) ||
+                (u64)stats.takenNb * 100 < (u64)stats.publishedNb * MIN_TAKEN_PERCENT) {
+            fprintf(stderr, "%s: %u published, %u taken, %u dropped, %u missing\n",
+                run->name, stats.publishedNb, stats.takenNb, stats.droppedNb,
+                missingNb);
+            rc = 1;
+        }
+
+        printf("%-28s %10.0f %10u %10u %10u %10u %8u ",
+            run->name, framesNb / s, stats.publishedNb, stats.takenNb,
+            stats.droppedNb, stats.rejectedNb, stats.maxQueuedNb);
+        for (size_t q = 0; q < NELS(stats.queuedHistogram); ++q)
+            printf(" %u", stats.queuedHistogram[q]);
+        printf("\n");
+    }
+    return rc;
+}
@@ -0,0 +1,20 @@
+#ifndef XIL_TYPES_H
+#define XIL_TYPES_H
+
+/*
+ * Just enough of xil_types.h of the standalone BSP for building the driver
+ * on the host.
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef char char8;
+typedef uintptr_t UINTPTR;
+typedef intptr_t INTPTR;
+
+#endif // XIL_TYPES_H
@@ -0,0 +1,15 @@
+#ifndef XSTATUS_H
+#define XSTATUS_H
+
+/*
+ * Just enough of xstatus.h of the standalone BSP for building the driver on
+ * the host.
+ */
+#include "xil_types.h"
+
+typedef s32 XStatus;
+
+#define XST_SUCCESS 0L
+#define XST_FAILURE 1L
+
+#endif // XSTATUS_H
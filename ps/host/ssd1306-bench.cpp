@@ -0,0 +1,702 @@
+/*
+ * Plays the animations of ps/resources, those of the demo and aha, countdown
+ * and doom, through FramePresenter and the Ssd1306 driver on the host, with
+ * the registers replaced by RecordingBus, and reports what it took per frame.
+ * The frames are decoded from the packed animations, like on the target, and
+ * checked against the raw ones. So are the frames streamed from their
+ * containers, by FrameStream out of memory and out of a file, against the
+ * packed ones. A container whose reference frame points at a delta frame has
+ * to be refused. With -t the recorded register accesses are printed as well,
+ * one per line: time [ns], r/w, offset, value.
+ *
+ * Every animation is played twice, with its frames written to the visible
+ * rows and then double buffered (+db), i.e. written to the off-screen half of
+ * GDDRAM and flipped on screen.
+ *
+ * The dashboard row is drawn live on a Canvas instead: a bar graph where one
+ * bar changes per frame, and a clock-like marker running along the bottom.
+ *
+ * Then all of it is played once more with the register writes going to
+ * Ssd1306Model as well, and what the panel shows is checked against every
+ * frame presented, the golden images. The dashboard is checked twice there,
+ * on the lower half of GDDRAM and with the upper one on screen (dash+up), as
+ * double buffering may have left it. That table reports per frame the bytes
+ * the panel got (commands included) and the bytes of the visible image that
+ * changed, and their ratio. With -p dir the panel images go to dir as well,
+ * one PBM per frame.
+ *
+ * Last, the panel is put to sleep, a frame is staged while it is, and it is
+ * resumed. It has to be blank in between and show the frame after, with the
+ * command bytes of the resume reported against those of the cold power on.
+ * And a script that fills GDDRAM with a checkerboard is loaded into the IP
+ * and run, with a single register write, and GDDRAM is checked after it.
+ * Vertical scrolling out of the bounds of the datasheet has to be refused
+ * without a byte sent.
+ *
+ * Usage: ssd1306-bench [-t] [-p dir]
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include "RecordingBus.hpp"
+#include "Ssd1306.hpp"
+#include "FramePresenter.hpp"
+#include "FrameDecoder.hpp"
+#include "FrameStream.hpp"
+#include "MemoryStorage.hpp"
+#include "FileStorage.hpp"
+#include "Canvas.hpp"
+
+#define NELS(a) (sizeof(a) / sizeof(a[0]))
+
+typedef Ssd1306<RecordingBus> Display;
+typedef FramePresenter<Display> Presenter;
+
+struct Frames {
+    u32 buffer[1*128];
+    int delay;
+};
+
+static Frames frames1[] =
+#include "380r-u32.inc"
+
+static Frames frames2[] =
+#include "aha2-u32.inc"
+
+static Frames frames3[] =
+#include "cascade-u32.inc"
+
+static Frames frames4[] =
+#include "eyes-u32.inc"
+
+static Frames frames5[] =
+#include "aha-u32.inc"
+
+static Frames frames6[] =
+#include "countdown-u32.inc"
+
+static Frames frames7[] =
+#include "doom-u32.inc"
+
+static const u8 packed1[] =
+#include "380r-packed.inc"
+
+static const u8 packed2[] =
+#include "aha2-packed.inc"
+
+static const u8 packed3[] =
+#include "cascade-packed.inc"
+
+static const u8 packed4[] =
+#include "eyes-packed.inc"
+
+static const u8 packed5[] =
+#include "aha-packed.inc"
+
+static const u8 packed6[] =
+#include "countdown-packed.inc"
+
+static const u8 packed7[] =
+#include "doom-packed.inc"
+
+static const u8 container1[] =
+#include "380r-anim.inc"
+
+static const u8 container2[] =
+#include "aha2-anim.inc"
+
+static const u8 container3[] =
+#include "cascade-anim.inc"
+
+static const u8 container4[] =
+#include "eyes-anim.inc"
+
+static const u8 container5[] =
+#include "aha-anim.inc"
+
+static const u8 container6[] =
+#include "countdown-anim.inc"
+
+static const u8 container7[] =
+#include "doom-anim.inc"
+
+struct Animation {
+    const char  *name;
+    Frames      *frames;
+    size_t      framesNb;
+    const u8    *packed;
+    size_t      packedSize;
+    const u8    *container;
+    size_t      containerSize;
+};
+
+static const int LOOPS_NB = 100;
+static const int DASHBOARD_FRAMES_NB = 1000;
+
+static int
+countMismatches(const Ssd1306Model *panel, const u32 frame[])
+{
+    /* Pixels of the panel that differ from the frame. */
+    int mismatchesNb = 0;
+    for (int y = 0; y < Ssd1306Model::PANEL_ROWS_NB; ++y) {
+        for (int x = 0; x < Ssd1306Model::WIDTH; ++x) {
+            u32 word = frame[(y / 8) * 32 + x / 4];
+            bool isLit = (word >> ((3 - x % 4) * 8 + y % 8)) & 1;
+            mismatchesNb += isLit != panel->getPixel(x, y);
+        }
+    }
+    return mismatchesNb;
+}
+
+static int
+countChangedBytes(const u32 previous[], const u32 frame[])
+{
+    /* Bytes, 8 rows of a column, that differ between the two frames. */
+    int changedNb = 0;
+    for (int i = 0; i < FrameDecoder::WORDS_NB; ++i) {
+        u32 diff = previous[i] ^ frame[i];
+        for (int b = 0; b < 4; ++b)
+            changedNb += ((diff >> (8 * b)) & 0xFF) != 0;
+    }
+    return changedNb;
+}
+
+static bool
+dumpPanel(const Ssd1306Model *panel, const char *dir, const char *name, size_t i)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s-%04zu.pbm", dir, name, i);
+    FILE *fp = fopen(path, "wb");
+    if (fp == 0) {
+        perror(path);
+        return false;
+    }
+    bool isOk = panel->writePbm(fp);
+    return fclose(fp) == 0 && isOk;
+}
+
+template <class Storage>
+static bool
+checkStream(const Animation *animation, const Storage &storage, const char *from)
+{
+    /* The container must play as the packed frames do, twice over. */
+    FrameDecoder decoder(animation->packed, animation->packedSize);
+    FrameStream<Storage> stream(storage);
+    u32 expected[FrameDecoder::WORDS_NB];
+    u32 frame[FrameDecoder::WORDS_NB];
+
+    if (stream.getFramesNb() != decoder.getFramesNb()) {
+        fprintf(stderr, "%s: %zu frames streamed from %s\n",
+            animation->name, stream.getFramesNb(), from);
+        return false;
+    }
+
+    memset(expected, 0, sizeof(expected));
+    memset(frame, 0, sizeof(frame));
+    for (size_t i = 0; i < 2 * decoder.getFramesNb(); ++i) {
+        int delay = decoder.decode(expected);
+        if (stream.decode(frame) != delay ||
+                memcmp(frame, expected, sizeof(frame)) != 0) {
+            fprintf(stderr, "%s: frame %zu streamed from %s differs\n",
+                animation->name, i % decoder.getFramesNb(), from);
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline u32
+getLe(const u8 *p, int nb)
+{
+    /* The little endian number of nb bytes at p. */
+    u32 value = 0;
+    for (int i = nb - 1; i >= 0; --i)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+static bool
+checkBadReference(const Animation *animation)
+{
+    /*
+     * A reference frame pointed at a frame that is not an intra one has to be
+     * refused, and the frames before it played as they are.
+     */
+    std::vector<u8> container(animation->container,
+        animation->container + animation->containerSize);
+    u8 *data = &container[0];
+    size_t framesNb = getLe(data + 6, 2);
+    const u8 *index = data + getLe(data + 8, 4);
+    u8 *payloads = data + getLe(data + 12, 4);
+
+    size_t referenceIdx = framesNb;
+    u32 deltaOffset = 0;
+    bool hasDelta = false;
+    for (size_t i = 0; i < framesNb; ++i) {
+        u32 offset = getLe(index + i * FrameStream<MemoryStorage>::ENTRY_SIZE, 4);
+        u8 flags = payloads[offset];
+        if (flags & FRAME_DECODER_IS_REFERENCE_MASK) {
+            if (referenceIdx == framesNb)
+                referenceIdx = i;
+        }
+        else if (!(flags & FRAME_DECODER_IS_INTRA_MASK) && !hasDelta) {
+            deltaOffset = offset;
+            hasDelta = true;
+        }
+    }
+    if (referenceIdx == framesNb || !hasDelta)
+        return true; /* Nothing to point wrong. */
+
+    u8 *reference =
+        payloads + getLe(index + referenceIdx * FrameStream<MemoryStorage>::ENTRY_SIZE, 4);
+    reference[3] = (u8)deltaOffset;
+    reference[4] = (u8)(deltaOffset >> 8);
+    reference[5] = (u8)(deltaOffset >> 16);
+
+    FrameStream<MemoryStorage> stream(MemoryStorage(data, container.size()));
+    u32 frame[FrameDecoder::WORDS_NB];
+    memset(frame, 0, sizeof(frame));
+    for (size_t i = 0; i < referenceIdx; ++i) {
+        if (stream.decode(frame) < 0) {
+            fprintf(stderr, "%s: frame %zu refused\n", animation->name, i);
+            return false;
+        }
+    }
+    if (stream.decode(frame) >= 0) {
+        fprintf(stderr, "%s: frame %zu referencing a delta frame taken\n",
+            animation->name, referenceIdx);
+        return false;
+    }
+    return true;
+}
+
+struct PanelCheck {
+    const char      *name;
+    size_t          framesNb;
+    size_t          mismatchesNb;
+        /* Frames shown wrong. */
+    u64             bytesNb;
+        /* Bytes the panel got. */
+    u64             changedNb;
+        /* Bytes of the visible image that changed. */
+    u32             previous[FrameDecoder::WORDS_NB];
+};
+
+static bool
+checkPanel(PanelCheck *check, const Ssd1306Model *panel, const u32 frame[],
+        const char *dir)
+{
+    /* The panel after frame was presented, the start is at framesNb 0. */
+    int mismatchesNb = countMismatches(panel, frame);
+    if (mismatchesNb > 0) {
+        if (check->mismatchesNb == 0)
+            fprintf(stderr, "%s: frame %zu shown with %d pixels wrong\n",
+                check->name, check->framesNb, mismatchesNb);
+        ++check->mismatchesNb;
+    }
+    check->changedNb += countChangedBytes(check->previous, frame);
+    memcpy(check->previous, frame, sizeof(check->previous));
+
+    bool isOk = dir == 0 || dumpPanel(panel, dir, check->name, check->framesNb);
+    ++check->framesNb;
+    return isOk;
+}
+
+static void
+printPanelCheck(const PanelCheck *check, const Ssd1306Model *panel, double ns)
+{
+    u64 bytesNb = panel->getCommandsNb() + panel->getDataNb() - check->bytesNb;
+    printf("%-12s %8zu %10zu %10.1f %10.1f %10.2f %10.0f\n",
+        check->name,
+        check->framesNb,
+        check->mismatchesNb,
+        bytesNb / (double)check->framesNb,
+        check->changedNb / (double)check->framesNb,
+        check->changedNb > 0 ? bytesNb / (double)check->changedNb : 0.0,
+        ns / check->framesNb
+    );
+}
+
+static void
+startPanelCheck(PanelCheck *check, const char *name, const Ssd1306Model *panel,
+        const u32 shown[])
+{
+    check->name = name;
+    check->framesNb = 0;
+    check->mismatchesNb = 0;
+    check->bytesNb = panel->getCommandsNb() + panel->getDataNb();
+    check->changedNb = 0;
+    memcpy(check->previous, shown, sizeof(check->previous));
+}
+
+static void
+drawDashboard(Canvas *canvas, int t)
+{
+    /* 16 bars of 6 columns above a 2-row marker track. */
+    int bar = t % 16;
+    int height = 1 + (t * 7 + bar * 5) % 27;
+    canvas->fillRect(bar * 8, 0, 6, 28, false);
+    canvas->fillRect(bar * 8, 28 - height, 6, height);
+
+    canvas->hLine((t + 127) % 128, 30, 1, false);
+    canvas->hLine((t + 127) % 128, 31, 1, false);
+    canvas->fillRect(t % 128, 30, 1, 2);
+}
+
+int
+main(int argc, char *argv[]) {
+
+    static
+    Animation animations[] = {
+        { "380r", frames1, NELS(frames1), packed1, sizeof(packed1),
+            container1, sizeof(container1) },
+        { "aha2", frames2, NELS(frames2), packed2, sizeof(packed2),
+            container2, sizeof(container2) },
+        { "cascade", frames3, NELS(frames3), packed3, sizeof(packed3),
+            container3, sizeof(container3) },
+        { "eyes", frames4, NELS(frames4), packed4, sizeof(packed4),
+            container4, sizeof(container4) },
+        { "aha", frames5, NELS(frames5), packed5, sizeof(packed5),
+            container5, sizeof(container5) },
+        { "countdown", frames6, NELS(frames6), packed6, sizeof(packed6),
+            container6, sizeof(container6) },
+        { "doom", frames7, NELS(frames7), packed7, sizeof(packed7),
+            container7, sizeof(container7) },
+    };
+
+    bool shouldTrace = false;
+    const char *dir = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "tp:")) != -1) {
+        switch (opt) {
+        case 't':
+            shouldTrace = true;
+            break;
+        case 'p':
+            dir = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-t] [-p dir]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    static
+    Display display;
+
+    static
+    Presenter presenter(&display);
+
+    display.powerOn();
+
+    int rc = 0;
+    printf("%-12s %8s %8s %10s %10s %10s %10s %10s\n",
+        "animation", "frames", "packed", "reads", "writes", "spi bytes",
+        "decode ns", "ns");
+    for (size_t a = 0; a < NELS(animations); ++a) {
+        Animation *animation = &animations[a];
+        int loopsNb = shouldTrace ? 1 : LOOPS_NB;
+
+        FrameDecoder decoder(animation->packed, animation->packedSize);
+        u32 frame[FrameDecoder::WORDS_NB];
+
+        /*
+         * The packed frames must decode to the raw ones, where a run of
+         * identical raw frames is packed as a single one with their delays
+         * summed up.
+         */
+        memset(frame, 0, sizeof(frame));
+        double decodeNs = 0;
+        for (int loop = 0; loop < loopsNb; ++loop) {
+            size_t r = 0;
+            std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+            for (size_t i = 0; i < decoder.getFramesNb(); ++i) {
+                int delay = decoder.decode(frame);
+                if (loop > 0)
+                    continue;
+
+                int rawDelay = 0;
+                size_t rawFramesNb = 0;
+                while (r < animation->framesNb &&
+                        memcmp(frame, animation->frames[r].buffer, sizeof(frame)) == 0 &&
+                        (rawFramesNb == 0 || rawDelay + animation->frames[r].delay <= delay)) {
+                    rawDelay += animation->frames[r++].delay;
+                    ++rawFramesNb;
+                }
+                if (rawFramesNb == 0 || rawDelay != delay) {
+                    fprintf(stderr, "%s: frame %zu differs\n",
+                        animation->name, i);
+                    rc = 1;
+                }
+            }
+            decodeNs +=
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start
+                ).count();
+            if (loop == 0 && r != animation->framesNb) {
+                fprintf(stderr, "%s: %zu raw frames left over\n",
+                    animation->name, animation->framesNb - r);
+                rc = 1;
+            }
+        }
+
+        if (!checkStream(animation,
+                MemoryStorage(animation->container, animation->containerSize), "memory"))
+            rc = 1;
+
+        if (!checkBadReference(animation))
+            rc = 1;
+
+        FILE *fp = tmpfile();
+        if (fp == 0 ||
+                fwrite(animation->container, 1, animation->containerSize, fp) !=
+                    animation->containerSize ||
+                !checkStream(animation, FileStorage(fp), "a file"))
+            rc = 1;
+        if (fp != 0)
+            fclose(fp);
+
+        for (int isDoubleBuffered = 0; isDoubleBuffered < 2; ++isDoubleBuffered) {
+            /* Straight to the visible rows, then through the off-screen half. */
+            presenter.setDoubleBuffered(isDoubleBuffered);
+            decoder.rewind();
+            RecordingBus::clear();
+            u32 readsNb = display.getMmioReadsNb();
+            u32 writesNb = display.getMmioWritesNb();
+            size_t bytesNb = 0;
+
+            std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+            for (int loop = 0; loop < loopsNb; ++loop) {
+                for (size_t i = 0; i < decoder.getFramesNb(); ++i) {
+                    decoder.decode(frame);
+                    presenter.present(frame);
+                    bytesNb += presenter.getBytesNb();
+                }
+            }
+            double ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start
+                ).count();
+
+            /* Per frame. */
+            double framesNb = (double)loopsNb * decoder.getFramesNb();
+            char name[32];
+            snprintf(name, sizeof(name), "%s%s",
+                animation->name, isDoubleBuffered ? "+db" : "");
+            printf("%-12s %8zu %8zu %10.1f %10.1f %10.1f %10.0f %10.0f\n",
+                name,
+                decoder.getFramesNb(),
+                animation->packedSize,
+                (display.getMmioReadsNb() - readsNb) / framesNb,
+                (display.getMmioWritesNb() - writesNb) / framesNb,
+                bytesNb / framesNb,
+                decodeNs / framesNb,
+                ns / framesNb
+            );
+
+            if (shouldTrace) {
+                std::vector<RecordingBus::Access> &accesses =
+                    RecordingBus::accesses();
+                for (size_t i = 0; i < accesses.size(); ++i) {
+                    printf("%llu %c %2u 0x%08x\n",
+                        (unsigned long long)accesses[i].time,
+                        accesses[i].isWrite ? 'w' : 'r',
+                        (unsigned)accesses[i].offset,
+                        (unsigned)accesses[i].value
+                    );
+                }
+            }
+        }
+    }
+
+    static
+    Canvas canvas;
+
+    RecordingBus::clear();
+    u32 readsNb = display.getMmioReadsNb();
+    u32 writesNb = display.getMmioWritesNb();
+    size_t bytesNb = canvas.present(&display);
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (int t = 0; t < DASHBOARD_FRAMES_NB; ++t) {
+        drawDashboard(&canvas, t);
+        bytesNb += canvas.present(&display);
+    }
+    double ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+    printf("%-12s %8d %8s %10.1f %10.1f %10.1f %10s %10.0f\n",
+        "dashboard",
+        DASHBOARD_FRAMES_NB,
+        "-",
+        (display.getMmioReadsNb() - readsNb) / (double)DASHBOARD_FRAMES_NB,
+        (display.getMmioWritesNb() - writesNb) / (double)DASHBOARD_FRAMES_NB,
+        bytesNb / (double)DASHBOARD_FRAMES_NB,
+        "-",
+        ns / DASHBOARD_FRAMES_NB
+    );
+
+    /* The golden images, the panel starts over from the power on. */
+    static
+    Ssd1306Model panel;
+
+    display.powerOff();
+    RecordingBus::panel() = &panel;
+    display.powerOn();
+    u64 coldCommandsNb = panel.getCommandsNb();
+
+    printf("\n%-12s %8s %10s %10s %10s %10s %10s\n",
+        "panel", "frames", "wrong", "spi bytes", "changed", "spi/change", "ns");
+    static
+    PanelCheck check;
+    u32 shown[FrameDecoder::WORDS_NB];
+    memset(shown, 0, sizeof(shown));
+    for (size_t a = 0; a < NELS(animations); ++a) {
+        Animation *animation = &animations[a];
+        FrameDecoder decoder(animation->packed, animation->packedSize);
+        u32 frame[FrameDecoder::WORDS_NB];
+        memset(frame, 0, sizeof(frame));
+
+        for (int isDoubleBuffered = 0; isDoubleBuffered < 2; ++isDoubleBuffered) {
+            presenter.setDoubleBuffered(isDoubleBuffered);
+            decoder.rewind();
+
+            char name[32];
+            snprintf(name, sizeof(name), "%s%s",
+                animation->name, isDoubleBuffered ? "+db" : "");
+            startPanelCheck(&check, name, &panel, shown);
+
+            std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+            for (size_t i = 0; i < decoder.getFramesNb(); ++i) {
+                decoder.decode(frame);
+                presenter.present(frame);
+                if (!checkPanel(&check, &panel, frame, dir))
+                    return 1;
+            }
+            double ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start
+                ).count();
+            printPanelCheck(&check, &panel, ns);
+            rc |= check.mismatchesNb > 0;
+            memcpy(shown, frame, sizeof(shown));
+        }
+    }
+
+    /* The dashboard on either half of GDDRAM, as left by the presenter. */
+    for (int isUpper = 0; isUpper < 2; ++isUpper) {
+        presenter.setDoubleBuffered(isUpper);
+        presenter.present(shown);
+        while (presenter.getFirstVisiblePage() != (isUpper ? Presenter::PAGES_NB : 0)) {
+            /* Flip to the other half with a frame that differs. */
+            for (int i = 0; i < FrameDecoder::WORDS_NB; ++i)
+                shown[i] = ~shown[i];
+            presenter.present(shown);
+        }
+
+        canvas.clear();
+        canvas.markAllDirty();
+        startPanelCheck(&check, isUpper ? "dash+up" : "dashboard", &panel, shown);
+        start = std::chrono::steady_clock::now();
+        for (int t = 0; t < DASHBOARD_FRAMES_NB; ++t) {
+            drawDashboard(&canvas, t);
+            canvas.present(&display, presenter.getFirstVisiblePage());
+            if (!checkPanel(&check, &panel, canvas.getFrame(), dir))
+                return 1;
+        }
+        ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start
+            ).count();
+        printPanelCheck(&check, &panel, ns);
+        rc |= check.mismatchesNb > 0;
+        memcpy(shown, canvas.getFrame(), sizeof(shown));
+    }
+
+    /* Sleep and resume, with the first frame of the first animation staged. */
+    FrameDecoder decoder(animations[0].packed, animations[0].packedSize);
+    u32 staged[FrameDecoder::WORDS_NB];
+    memset(staged, 0, sizeof(staged));
+    decoder.decode(staged);
+
+    display.sleep();
+    presenter.invalidate();
+    presenter.present(staged);
+    bool isBlank = !panel.isDisplayOn();
+    u64 commandsNb = panel.getCommandsNb();
+    display.resume();
+    bool isAwake = display.waitForAwake(1) == 0;
+    u64 resumeCommandsNb = panel.getCommandsNb() - commandsNb;
+    int mismatchesNb = countMismatches(&panel, staged);
+
+    printf("\n%-12s %10s %10s %10s\n", "wake", "commands", "blank", "wrong");
+    printf("%-12s %10llu %10s %10s\n",
+        "cold", (unsigned long long)coldCommandsNb, "-", "-");
+    printf("%-12s %10llu %10s %10d\n",
+        "resume", (unsigned long long)resumeCommandsNb, isBlank ? "yes" : "no",
+        mismatchesNb);
+    rc |= !isBlank || !isAwake || mismatchesNb > 0 || resumeCommandsNb != 1;
+
+    /* A script that fills GDDRAM, columns of 0x55 and 0xAA in turn. */
+    static
+    Display::Script script;
+    const u8 pattern[] = { 0x55, 0xAA };
+    script.add(Display::MemoryAddressingMode, 0x00);
+    script.add(Display::ColumnAddress, (u8)0, Ssd1306Model::WIDTH - 1);
+    script.add(Display::PageAddress, (u8)0, Ssd1306Model::GDDRAM_PAGES_NB - 1);
+    script.beginLoop(Ssd1306Model::WIDTH * Ssd1306Model::GDDRAM_PAGES_NB / 2);
+    script.addData(pattern, sizeof(pattern));
+    script.endLoop();
+    int end = display.loadScript(0, script);
+
+    u32 scriptWritesNb = display.getMmioWritesNb();
+    u64 scriptBytesNb = panel.getCommandsNb() + panel.getDataNb();
+    display.runScript(0);
+    scriptWritesNb = display.getMmioWritesNb() - scriptWritesNb;
+    scriptBytesNb = panel.getCommandsNb() + panel.getDataNb() - scriptBytesNb;
+
+    int wrongNb = 0;
+    const u8 *gddram = panel.getGddram();
+    for (int i = 0; i < Ssd1306Model::WIDTH * Ssd1306Model::GDDRAM_PAGES_NB; ++i)
+        wrongNb += gddram[i] != pattern[i % 2];
+    presenter.invalidate();
+
+    printf("\n%-12s %10s %10s %10s %10s\n",
+        "script", "words", "writes", "spi bytes", "wrong");
+    printf("%-12s %10d %10u %10llu %10d\n",
+        "checkers", end, scriptWritesNb, (unsigned long long)scriptBytesNb, wrongNb);
+    rc |= end < 0 || scriptWritesNb != 1 || wrongNb > 0;
+
+    /*
+     * Vertical scrolling out of the bounds of the datasheet, more rows than
+     * the multiplex ratio or a step as long as the scrolled rows, and one
+     * just within them.
+     */
+    static const Display::Scroll scrolls[] = {
+        { Display::ScrollLeft, 0, 3, Display::Frames2, 1, 8, 25 },
+        { Display::ScrollLeft, 0, 3, Display::Frames2, 8, 0, 8 },
+        { Display::ScrollLeft, 0, 3, Display::Frames2, 31, 0, 32 },
+    };
+    printf("\n%-12s %10s %10s\n", "scroll", "rc", "spi bytes");
+    for (size_t i = 0; i < NELS(scrolls); ++i) {
+        u64 bytesNb = panel.getCommandsNb();
+        int scrollRc = display.startScroll(scrolls[i]);
+        bytesNb = panel.getCommandsNb() - bytesNb;
+        display.stopScroll();
+
+        char name[16];
+        snprintf(name, sizeof(name), "%d+%d/%d", scrolls[i].fixedRowsNb,
+            scrolls[i].scrolledRowsNb, scrolls[i].verticalOffset);
+        printf("%-12s %10d %10llu\n", name, scrollRc, (unsigned long long)bytesNb);
+        bool isValid = i == NELS(scrolls) - 1;
+        rc |= isValid ? scrollRc != 0 || bytesNb == 0 : scrollRc != -1 || bytesNb != 0;
+    }
+
+    return rc;
+}
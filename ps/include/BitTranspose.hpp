@@ -0,0 +1,344 @@
+#ifndef BIT_TRANSPOSE_HPP
+#define BIT_TRANSPOSE_HPP
+
+#include "xil_types.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BIT_TRANSPOSE_HAS_NEON 1
+#include <arm_neon.h>
+#endif
+#if defined(__SSE2__)
+#define BIT_TRANSPOSE_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define BIT_TRANSPOSE_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
+/*
+ * BitTranspose converts row-major 1-bit bitmaps into the page-major layout of
+ * the SSD1306 GDDRAM, where a byte holds 8 vertically adjacent pixels of a
+ * page, the topmost one in bit 0, and the bytes of a page go column by
+ * column.
+ *
+ * The bitmaps are laid out like XBM ones: rows of width / 8 bytes, top to
+ * bottom, with the leftmost pixel of a byte in bit 0. The width and the height
+ * must be multiples of 8. With isFlipped the columns are mirrored, which is
+ * what the asset pipeline does with `convert -flop`.
+ *
+ * Every 8x8 block of pixels is turned into its 8 page bytes with a single bit
+ * transpose of a 64-bit word. The SIMD paths first gather the blocks of 128
+ * columns of a page with byte unpacks, then transpose 2 blocks per 128-bit
+ * register; the AVX2 one does 2 pages at a time. toPages() picks the widest
+ * path the compiler targets, i.e. NEON on the Cortex-A9 when built with
+ * -mfpu=neon, and the scalar one otherwise.
+ */
+class BitTranspose {
+
+public:
+    static inline
+    void toPages(const u8 rows[], int width, int height, u8 pages[], bool isFlipped = false) {
+#if defined(BIT_TRANSPOSE_HAS_NEON)
+        toPagesNeon(rows, width, height, pages, isFlipped);
+#elif defined(BIT_TRANSPOSE_HAS_AVX2)
+        toPagesAvx2(rows, width, height, pages, isFlipped);
+#elif defined(BIT_TRANSPOSE_HAS_SSE2)
+        toPagesSse2(rows, width, height, pages, isFlipped);
+#else
+        toPagesScalar(rows, width, height, pages, isFlipped);
+#endif
+    }
+
+    static inline
+    void toFrame(const u8 rows[], int width, int height, u32 frame[], bool isFlipped = false) {
+        /*
+         * Convert into the frame layout of FramePresenter, words carrying 4
+         * consecutive columns of a page with the leftmost one in the MSB.
+         */
+        toPages(rows, width, height, (u8 *)frame, isFlipped);
+        for (int i = 0; i < width * height / 32; ++i) {
+            u32 w = frame[i];
+            const u8 *b = (const u8 *)&w;
+            frame[i] = ((u32)b[0] << 24) | ((u32)b[1] << 16) | ((u32)b[2] << 8) | b[3];
+        }
+    }
+
+    static inline
+    u64 transpose8x8(u64 x) {
+        /* Move bit c of byte r to bit r of byte c. */
+        u64 t;
+        t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAull;
+        x ^= t ^ (t << 7);
+        t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;
+        x ^= t ^ (t << 14);
+        t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;
+        x ^= t ^ (t << 28);
+        return x;
+    }
+
+    static inline
+    void toPagesScalar(const u8 rows[], int width, int height, u8 pages[], bool isFlipped = false) {
+        for (int page = 0; page < height / 8; ++page)
+            for (int x = 0; x < width; x += 8)
+                toPageBlock(rows, width, page, x, pages, isFlipped);
+    }
+
+#if defined(BIT_TRANSPOSE_HAS_SSE2)
+    static inline
+    void toPagesSse2(const u8 rows[], int width, int height, u8 pages[], bool isFlipped = false) {
+        int stride = width / 8;
+        for (int page = 0; page < height / 8; ++page) {
+            int x = 0;
+            for (; x + 128 <= width; x += 128) {
+                __m128i a[8], v[8];
+                for (int k = 0; k < 8; ++k)
+                    a[k] = _mm_loadu_si128((const __m128i *)&rows[(page * 8 + k) * stride + x / 8]);
+                gatherBlocks(a, v);
+
+                for (int j = 0; j < 8; ++j) {
+                    __m128i w = transpose8x8(v[j]);
+                    if (isFlipped)
+                        _mm_storeu_si128((__m128i *)&pages[page * width + width - x - 16 * (j + 1)], reverse(w));
+                    else
+                        _mm_storeu_si128((__m128i *)&pages[page * width + x + 16 * j], w);
+                }
+            }
+            for (; x < width; x += 8)
+                toPageBlock(rows, width, page, x, pages, isFlipped);
+        }
+    }
+#endif
+
+#if defined(BIT_TRANSPOSE_HAS_AVX2)
+    static inline
+    void toPagesAvx2(const u8 rows[], int width, int height, u8 pages[], bool isFlipped = false) {
+        int stride = width / 8;
+        int page = 0;
+        for (; page + 2 <= height / 8; page += 2) {
+            int x = 0;
+            for (; x + 128 <= width; x += 128) {
+                /* The low lanes hold page, the high lanes page + 1. */
+                __m256i a[8], v[8];
+                for (int k = 0; k < 8; ++k) {
+                    __m128i lo = _mm_loadu_si128((const __m128i *)&rows[(page * 8 + k) * stride + x / 8]);
+                    __m128i hi = _mm_loadu_si128((const __m128i *)&rows[(page * 8 + 8 + k) * stride + x / 8]);
+                    a[k] = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+                }
+                gatherBlocks(a, v);
+
+                for (int j = 0; j < 8; ++j) {
+                    __m256i w = transpose8x8(v[j]);
+                    int at = x + 16 * j;
+                    if (isFlipped) {
+                        w = reverse(w);
+                        at = width - x - 16 * (j + 1);
+                    }
+                    _mm_storeu_si128((__m128i *)&pages[page * width + at], _mm256_castsi256_si128(w));
+                    _mm_storeu_si128((__m128i *)&pages[(page + 1) * width + at], _mm256_extracti128_si256(w, 1));
+                }
+            }
+            for (; x < width; x += 8) {
+                toPageBlock(rows, width, page, x, pages, isFlipped);
+                toPageBlock(rows, width, page + 1, x, pages, isFlipped);
+            }
+        }
+        if (page < height / 8)
+            toPagesSse2(&rows[page * 8 * stride], width, 8, &pages[page * width], isFlipped);
+    }
+#endif
+
+#if defined(BIT_TRANSPOSE_HAS_NEON)
+    static inline
+    void toPagesNeon(const u8 rows[], int width, int height, u8 pages[], bool isFlipped = false) {
+        int stride = width / 8;
+        for (int page = 0; page < height / 8; ++page) {
+            int x = 0;
+            for (; x + 128 <= width; x += 128) {
+                uint8x16_t a[8], v[8];
+                for (int k = 0; k < 8; ++k)
+                    a[k] = vld1q_u8(&rows[(page * 8 + k) * stride + x / 8]);
+                gatherBlocks(a, v);
+
+                for (int j = 0; j < 8; ++j) {
+                    uint8x16_t w = transpose8x8(v[j]);
+                    if (isFlipped)
+                        vst1q_u8(&pages[page * width + width - x - 16 * (j + 1)], reverse(w));
+                    else
+                        vst1q_u8(&pages[page * width + x + 16 * j], w);
+                }
+            }
+            for (; x < width; x += 8)
+                toPageBlock(rows, width, page, x, pages, isFlipped);
+        }
+    }
+#endif
+
+private:
+    static inline
+    void toPageBlock(const u8 rows[], int width, int page, int x, u8 pages[], bool isFlipped) {
+        /* The 8x8 block of pixels at column x of page. */
+        int stride = width / 8;
+        const u8 *r = &rows[page * 8 * stride + x / 8];
+        u64 v = 0;
+        for (int k = 0; k < 8; ++k)
+            v |= (u64)r[k * stride] << (8 * k);
+        v = transpose8x8(v);
+
+        u8 *p = &pages[page * width];
+        for (int c = 0; c < 8; ++c)
+            p[isFlipped ? width - 1 - x - c : x + c] = v >> (8 * c);
+    }
+
+    /*
+     * The SIMD paths get 8 rows of 128 columns in a[], a row per register, and
+     * rearrange them so that every 64-bit lane of v[] holds the 8 rows of one
+     * 8-column block, v[0] the blocks 0 and 1, v[1] the blocks 2 and 3 and so
+     * on.
+     */
+#if defined(BIT_TRANSPOSE_HAS_SSE2)
+    static inline
+    void gatherBlocks(const __m128i a[8], __m128i v[8]) {
+        __m128i t[8], u[8];
+        for (int k = 0; k < 4; ++k) {
+            t[2 * k] = _mm_unpacklo_epi8(a[2 * k], a[2 * k + 1]);
+            t[2 * k + 1] = _mm_unpackhi_epi8(a[2 * k], a[2 * k + 1]);
+        }
+        for (int k = 0; k < 2; ++k) {
+            u[4 * k] = _mm_unpacklo_epi16(t[4 * k], t[4 * k + 2]);
+            u[4 * k + 1] = _mm_unpackhi_epi16(t[4 * k], t[4 * k + 2]);
+            u[4 * k + 2] = _mm_unpacklo_epi16(t[4 * k + 1], t[4 * k + 3]);
+            u[4 * k + 3] = _mm_unpackhi_epi16(t[4 * k + 1], t[4 * k + 3]);
+        }
+        for (int k = 0; k < 4; ++k) {
+            v[2 * k] = _mm_unpacklo_epi32(u[k], u[k + 4]);
+            v[2 * k + 1] = _mm_unpackhi_epi32(u[k], u[k + 4]);
+        }
+    }
+
+    static inline
+    __m128i transpose8x8(__m128i x) {
+        const __m128i m1 = _mm_set1_epi64x(0x00AA00AA00AA00AAll);
+        const __m128i m2 = _mm_set1_epi64x(0x0000CCCC0000CCCCll);
+        const __m128i m3 = _mm_set1_epi64x(0x00000000F0F0F0F0ll);
+        __m128i t;
+        t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 7)), m1);
+        x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_slli_epi64(t, 7)));
+        t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 14)), m2);
+        x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_slli_epi64(t, 14)));
+        t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 28)), m3);
+        x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_slli_epi64(t, 28)));
+        return x;
+    }
+
+    static inline
+    __m128i reverse(__m128i x) {
+        /* Reverse the order of the 16 bytes. */
+        x = _mm_shuffle_epi32(x, _MM_SHUFFLE(0, 1, 2, 3));
+        x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+        x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    }
+#endif
+
+#if defined(BIT_TRANSPOSE_HAS_AVX2)
+    static inline
+    void gatherBlocks(const __m256i a[8], __m256i v[8]) {
+        /* The same as the SSE2 one, the unpacks work on each lane apart. */
+        __m256i t[8], u[8];
+        for (int k = 0; k < 4; ++k) {
+            t[2 * k] = _mm256_unpacklo_epi8(a[2 * k], a[2 * k + 1]);
+            t[2 * k + 1] = _mm256_unpackhi_epi8(a[2 * k], a[2 * k + 1]);
+        }
+        for (int k = 0; k < 2; ++k) {
+            u[4 * k] = _mm256_unpacklo_epi16(t[4 * k], t[4 * k + 2]);
+            u[4 * k + 1] = _mm256_unpackhi_epi16(t[4 * k], t[4 * k + 2]);
+            u[4 * k + 2] = _mm256_unpacklo_epi16(t[4 * k + 1], t[4 * k + 3]);
+            u[4 * k + 3] = _mm256_unpackhi_epi16(t[4 * k + 1], t[4 * k + 3]);
+        }
+        for (int k = 0; k < 4; ++k) {
+            v[2 * k] = _mm256_unpacklo_epi32(u[k], u[k + 4]);
+            v[2 * k + 1] = _mm256_unpackhi_epi32(u[k], u[k + 4]);
+        }
+    }
+
+    static inline
+    __m256i transpose8x8(__m256i x) {
+        const __m256i m1 = _mm256_set1_epi64x(0x00AA00AA00AA00AAll);
+        const __m256i m2 = _mm256_set1_epi64x(0x0000CCCC0000CCCCll);
+        const __m256i m3 = _mm256_set1_epi64x(0x00000000F0F0F0F0ll);
+        __m256i t;
+        t = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 7)), m1);
+        x = _mm256_xor_si256(x, _mm256_xor_si256(t, _mm256_slli_epi64(t, 7)));
+        t = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 14)), m2);
+        x = _mm256_xor_si256(x, _mm256_xor_si256(t, _mm256_slli_epi64(t, 14)));
+        t = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 28)), m3);
+        x = _mm256_xor_si256(x, _mm256_xor_si256(t, _mm256_slli_epi64(t, 28)));
+        return x;
+    }
+
+    static inline
+    __m256i reverse(__m256i x) {
+        /* Reverse the order of the 16 bytes of each lane. */
+        const __m256i indices = _mm256_setr_epi8(
+            15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+            15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+        );
+        return _mm256_shuffle_epi8(x, indices);
+    }
+#endif
+
+#if defined(BIT_TRANSPOSE_HAS_NEON)
+    static inline
+    void gatherBlocks(const uint8x16_t a[8], uint8x16_t v[8]) {
+        uint16x8_t t[8];
+        uint32x4_t u[8];
+        for (int k = 0; k < 4; ++k) {
+            uint8x16x2_t z = vzipq_u8(a[2 * k], a[2 * k + 1]);
+            t[2 * k] = vreinterpretq_u16_u8(z.val[0]);
+            t[2 * k + 1] = vreinterpretq_u16_u8(z.val[1]);
+        }
+        for (int k = 0; k < 2; ++k) {
+            uint16x8x2_t z0 = vzipq_u16(t[4 * k], t[4 * k + 2]);
+            uint16x8x2_t z1 = vzipq_u16(t[4 * k + 1], t[4 * k + 3]);
+            u[4 * k] = vreinterpretq_u32_u16(z0.val[0]);
+            u[4 * k + 1] = vreinterpretq_u32_u16(z0.val[1]);
+            u[4 * k + 2] = vreinterpretq_u32_u16(z1.val[0]);
+            u[4 * k + 3] = vreinterpretq_u32_u16(z1.val[1]);
+        }
+        for (int k = 0; k < 4; ++k) {
+            uint32x4x2_t z = vzipq_u32(u[k], u[k + 4]);
+            v[2 * k] = vreinterpretq_u8_u32(z.val[0]);
+            v[2 * k + 1] = vreinterpretq_u8_u32(z.val[1]);
+        }
+    }
+
+    static inline
+    uint8x16_t transpose8x8(uint8x16_t v) {
+        const uint64x2_t m1 = vdupq_n_u64(0x00AA00AA00AA00AAull);
+        const uint64x2_t m2 = vdupq_n_u64(0x0000CCCC0000CCCCull);
+        const uint64x2_t m3 = vdupq_n_u64(0x00000000F0F0F0F0ull);
+        uint64x2_t x = vreinterpretq_u64_u8(v);
+        uint64x2_t t;
+        t = vandq_u64(veorq_u64(x, vshrq_n_u64(x, 7)), m1);
+        x = veorq_u64(x, veorq_u64(t, vshlq_n_u64(t, 7)));
+        t = vandq_u64(veorq_u64(x, vshrq_n_u64(x, 14)), m2);
+        x = veorq_u64(x, veorq_u64(t, vshlq_n_u64(t, 14)));
+        t = vandq_u64(veorq_u64(x, vshrq_n_u64(x, 28)), m3);
+        x = veorq_u64(x, veorq_u64(t, vshlq_n_u64(t, 28)));
+        return vreinterpretq_u8_u64(x);
+    }
+
+    static inline
+    uint8x16_t reverse(uint8x16_t x) {
+        /* Reverse the order of the 16 bytes. */
+        x = vrev64q_u8(x);
+        return vcombine_u8(vget_high_u8(x), vget_low_u8(x));
+    }
+#endif
+
+    /* Only static members. */
+    BitTranspose() {};
+};
+
+#endif // BIT_TRANSPOSE_HPP
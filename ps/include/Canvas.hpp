@@ -0,0 +1,337 @@
+#ifndef CANVAS_HPP
+#define CANVAS_HPP
+
+#include <string.h>
+#include "xil_types.h"
+
+/*
+ * Canvas is a 128x32 drawing surface kept in the frame layout of
+ * FramePresenter, i.e. in the page-major layout of GDDRAM packed into u32
+ * words of 4 columns (the leftmost one in the MSB), so its pixels go to the
+ * display as they are.
+ *
+ * Every drawing call widens the dirty column range of the pages it touches
+ * and present() sends only those ranges, rounded out to whole words. Spans,
+ * rectangles and page-aligned blits work on whole words where they can: a
+ * word covers 4 columns of a page, so setting the same rows in all of them
+ * is a single OR with the page mask repeated in every byte.
+ *
+ * The coordinates are clipped, x grows to the right and y downwards.
+ */
+class Canvas {
+
+public:
+    static const int WIDTH = 128;
+    static const int HEIGHT = 32;
+    static const int PAGES_NB = HEIGHT / 8;
+    static const int COLUMNS_PER_WORD = 4;
+    static const int WORDS_PER_PAGE = WIDTH / COLUMNS_PER_WORD;
+    static const int WORDS_NB = PAGES_NB * WORDS_PER_PAGE;
+
+    enum BlitMode {
+        Copy,
+            /* The bitmap replaces what is under it. */
+        Or,
+            /* Only the set pixels of the bitmap are drawn, like a sprite. */
+    };
+
+    Canvas() {
+        memset(frame, 0, sizeof(frame));
+        markAllDirty();
+    }
+
+    inline
+    void clear(bool isOn = false) {
+        memset(frame, isOn ? 0xFF : 0x00, sizeof(frame));
+        markAllDirty();
+    }
+
+    inline
+    void setPixel(int x, int y, bool isOn = true) {
+        if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
+            return;
+
+        u32 *w = &frame[(y / 8) * WORDS_PER_PAGE + x / COLUMNS_PER_WORD];
+        u32 bit = (u32)1 << (byteShift(x) + y % 8);
+        *w = isOn ? *w | bit : *w & ~bit;
+        markDirty(y / 8, x, x);
+    }
+
+    inline
+    bool getPixel(int x, int y) const {
+        if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
+            return false;
+
+        u32 w = frame[(y / 8) * WORDS_PER_PAGE + x / COLUMNS_PER_WORD];
+        return (w >> (byteShift(x) + y % 8)) & 1;
+    }
+
+    inline
+    void hLine(int x, int y, int w, bool isOn = true) {
+        fillRect(x, y, w, 1, isOn);
+    }
+
+    inline
+    void vLine(int x, int y, int h, bool isOn = true) {
+        fillRect(x, y, 1, h, isOn);
+    }
+
+    inline
+    void fillRect(int x, int y, int w, int h, bool isOn = true) {
+        if (!clip(x, y, w, h))
+            return;
+
+        int lastX = x + w - 1;
+        int lastY = y + h - 1;
+        for (int page = y / 8; page <= lastY / 8; ++page) {
+            /* The rows of the rectangle within the page, in every byte. */
+            int first = page == y / 8 ? y % 8 : 0;
+            int last = page == lastY / 8 ? lastY % 8 : 7;
+            u32 rows = (((u32)2 << last) - ((u32)1 << first)) * 0x01010101;
+
+            u32 *words = &frame[page * WORDS_PER_PAGE];
+            int firstWord = x / COLUMNS_PER_WORD;
+            int lastWord = lastX / COLUMNS_PER_WORD;
+            for (int i = firstWord; i <= lastWord; ++i) {
+                u32 mask = rows;
+                if (i == firstWord)
+                    mask &= columnsFrom(x % COLUMNS_PER_WORD);
+                if (i == lastWord)
+                    mask &= ~columnsFrom(lastX % COLUMNS_PER_WORD + 1);
+                words[i] = isOn ? words[i] | mask : words[i] & ~mask;
+            }
+            markDirty(page, x, lastX);
+        }
+    }
+
+    inline
+    void rect(int x, int y, int w, int h, bool isOn = true) {
+        if (w <= 0 || h <= 0)
+            return;
+
+        hLine(x, y, w, isOn);
+        hLine(x, y + h - 1, w, isOn);
+        vLine(x, y + 1, h - 2, isOn);
+        vLine(x + w - 1, y + 1, h - 2, isOn);
+    }
+
+    inline
+    void line(int x0, int y0, int x1, int y1, bool isOn = true) {
+        /* Bresenham, the straight ones go through fillRect(). */
+        if (y0 == y1) {
+            hLine(x0 < x1 ? x0 : x1, y0, (x0 < x1 ? x1 - x0 : x0 - x1) + 1, isOn);
+            return;
+        }
+        if (x0 == x1) {
+            vLine(x0, y0 < y1 ? y0 : y1, (y0 < y1 ? y1 - y0 : y0 - y1) + 1, isOn);
+            return;
+        }
+
+        int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+        int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+        int sx = x0 < x1 ? 1 : -1;
+        int sy = y0 < y1 ? 1 : -1;
+        int err = dx + dy;
+        while (true) {
+            setPixel(x0, y0, isOn);
+            if (x0 == x1 && y0 == y1)
+                break;
+            int e2 = 2 * err;
+            if (e2 >= dy) {
+                err += dy;
+                x0 += sx;
+            }
+            if (e2 <= dx) {
+                err += dx;
+                y0 += sy;
+            }
+        }
+    }
+
+    inline
+    void blit(const u8 bitmap[], int bw, int bh, int x, int y, BlitMode mode = Copy) {
+        /*
+         * Draw a page-major bitmap of bw columns and bh rows (a multiple of 8),
+         * e.g. one converted with BitTranspose::toPages(), with its top left
+         * corner at x, y.
+         */
+        int shift = ((y % 8) + 8) % 8;
+        int firstPage = (y - shift) / 8;
+
+        for (int bp = 0; bp < bh / 8; ++bp) {
+            const u8 *src = &bitmap[bp * bw];
+
+            /* A bitmap page lands on one page, or straddles two. */
+            for (int half = 0; half < (shift ? 2 : 1); ++half) {
+                int page = firstPage + bp + half;
+                if (page < 0 || page >= PAGES_NB)
+                    continue;
+
+                int first = x < 0 ? -x : 0;
+                int last = x + bw > WIDTH ? WIDTH - x - 1 : bw - 1;
+                if (first > last)
+                    continue;
+
+                u8 keep = half == 0 ? (u8)~(0xFF << shift) : (u8)(0xFF << shift);
+                int c = first;
+
+                /* Whole words, 4 columns at a time, when they line up. */
+                if (shift == 0 && (x + c) % COLUMNS_PER_WORD == 0) {
+                    u32 *words = &frame[page * WORDS_PER_PAGE + (x + c) / COLUMNS_PER_WORD];
+                    for (; c + COLUMNS_PER_WORD - 1 <= last; c += COLUMNS_PER_WORD) {
+                        u32 bits =
+                            ((u32)src[c] << 24) | ((u32)src[c + 1] << 16) |
+                            ((u32)src[c + 2] << 8) | src[c + 3];
+                        *words = mode == Copy ? bits : *words | bits;
+                        ++words;
+                    }
+                }
+
+                for (; c <= last; ++c) {
+                    u8 bits = half == 0 ? src[c] << shift : src[c] >> (8 - shift);
+                    int column = x + c;
+                    u32 *w = &frame[page * WORDS_PER_PAGE + column / COLUMNS_PER_WORD];
+                    int s = byteShift(column);
+                    u8 old = *w >> s;
+                    u8 b = mode == Copy ? (old & keep) | bits : old | bits;
+                    *w = (*w & ~((u32)0xFF << s)) | ((u32)b << s);
+                }
+                markDirty(page, x + first, x + last);
+            }
+        }
+    }
+
+    template <class Display>
+    inline
+    size_t present(Display *display, int firstPage = 0) {
+        /*
+         * Send the dirty column ranges to the display and return the number
+         * of bytes that went over SPI. The words are queued in the TX FIFO
+         * before this returns, so drawing can go on right away.
+         *
+         * firstPage is the GDDRAM page on the top row of the panel, i.e.
+         * FramePresenter::getFirstVisiblePage() when double buffering has
+         * scrolled the upper half into view.
+         */
+        typename Display::Batch batch;
+        size_t bytesNb = 0;
+
+        for (int page = 0; page < PAGES_NB; ++page) {
+            if (firstColumns[page] > lastColumns[page])
+                continue;
+
+            /* Pages with the same range go out as a single window. */
+            int firstWord = firstColumns[page] / COLUMNS_PER_WORD;
+            int lastWord = lastColumns[page] / COLUMNS_PER_WORD;
+            int lastPage = page;
+            while (lastPage + 1 < PAGES_NB &&
+                    firstColumns[lastPage + 1] / COLUMNS_PER_WORD == firstWord &&
+                    lastColumns[lastPage + 1] / COLUMNS_PER_WORD == lastWord &&
+                    firstColumns[lastPage + 1] <= lastColumns[lastPage + 1])
+                ++lastPage;
+
+            int wordsNb = lastWord - firstWord + 1;
+            batch.add(
+                Display::ColumnAddress,
+                firstWord * COLUMNS_PER_WORD,
+                (lastWord + 1) * COLUMNS_PER_WORD - 1
+            );
+            batch.add(Display::PageAddress, firstPage + page, firstPage + lastPage);
+            if (wordsNb == WORDS_PER_PAGE) {
+                /* Whole pages are contiguous. */
+                batch.add(&frame[page * WORDS_PER_PAGE], (lastPage - page + 1) * WORDS_PER_PAGE);
+            }
+            else {
+                for (int p = page; p <= lastPage; ++p)
+                    batch.add(&frame[p * WORDS_PER_PAGE + firstWord], wordsNb);
+            }
+            bytesNb += 6 + (lastPage - page + 1) * wordsNb * COLUMNS_PER_WORD;
+            page = lastPage;
+        }
+
+        if (bytesNb > 0)
+            display->submit(batch);
+        markClean();
+        return bytesNb;
+    }
+
+    inline
+    void markAllDirty() {
+        /* Make the next present() send everything, e.g. after a power cycle. */
+        for (int page = 0; page < PAGES_NB; ++page) {
+            firstColumns[page] = 0;
+            lastColumns[page] = WIDTH - 1;
+        }
+    }
+
+    inline
+    bool isDirty() const {
+        for (int page = 0; page < PAGES_NB; ++page)
+            if (firstColumns[page] <= lastColumns[page])
+                return true;
+        return false;
+    }
+
+    inline
+    const u32 *getFrame() const {
+        /* The pixels, e.g. for FramePresenter::present(). */
+        return frame;
+    }
+
+private:
+    static inline
+    int byteShift(int x) {
+        /* The shift of the byte of column x in its word. */
+        return (COLUMNS_PER_WORD - 1 - x % COLUMNS_PER_WORD) * 8;
+    }
+
+    static inline
+    u32 columnsFrom(int c) {
+        /* The bytes of the columns c and on in a word, none for c == 4. */
+        return c >= COLUMNS_PER_WORD ? 0 : (u32)(((u64)1 << (byteShift(c) + 8)) - 1);
+    }
+
+    inline
+    bool clip(int &x, int &y, int &w, int &h) const {
+        if (x < 0) {
+            w += x;
+            x = 0;
+        }
+        if (y < 0) {
+            h += y;
+            y = 0;
+        }
+        if (x + w > WIDTH)
+            w = WIDTH - x;
+        if (y + h > HEIGHT)
+            h = HEIGHT - y;
+        return w > 0 && h > 0;
+    }
+
+    inline
+    void markDirty(int page, int first, int last) {
+        if (first < firstColumns[page])
+            firstColumns[page] = first;
+        if (last > lastColumns[page])
+            lastColumns[page] = last;
+    }
+
+    inline
+    void markClean() {
+        for (int page = 0; page < PAGES_NB; ++page) {
+            firstColumns[page] = WIDTH;
+            lastColumns[page] = -1;
+        }
+    }
+
+    u32             frame[WORDS_NB];
+        /* The pixels, in the frame layout of FramePresenter. */
+
+    int             firstColumns[PAGES_NB];
+        /* The first dirty column of every page, WIDTH when it is clean. */
+
+    int             lastColumns[PAGES_NB];
+        /* The last dirty column of every page, -1 when it is clean. */
+};
+
+#endif // CANVAS_HPP
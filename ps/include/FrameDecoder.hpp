@@ -0,0 +1,202 @@
+#ifndef FRAME_DECODER_HPP
+#define FRAME_DECODER_HPP
+
+#include <stddef.h>
+#include <string.h>
+#include "xil_types.h"
+
+/*
+ * FrameDecoder plays back the frames packed by utils/framepack, one frame at
+ * a time and in place, so an animation needs only a single 512-byte frame
+ * buffer in RAM next to its packed bytes.
+ *
+ * Every frame is a 3-byte header, the flags and the delay [ms] as u16 little
+ * endian, followed by tokens that produce the 128 words of the frame in order.
+ * The top 2 bits of a token byte select the operation, the low 6 bits hold the
+ * number of words minus one:
+ *
+ *   Skip    - the words stay as they are, i.e. as in the previous frame,
+ *   Run     - the words are set to the little endian word that follows,
+ *   Literal - the words follow, little endian.
+ *
+ * An intra frame is decoded over a cleared buffer, any other over the previous
+ * frame, so the frames must be decoded in order and into the same buffer.
+ * A reference frame, a repeat of an earlier frame, carries no tokens but the
+ * offset (u24 little endian) of the header of that frame, which is an intra
+ * one.
+ *
+ * Decoding a frame is a single pass over at most ~520 bytes, a small fraction
+ * of the time the display takes to get the same frame over SPI.
+ */
+class FrameDecoder {
+
+public:
+    static const int WORDS_NB = 128;
+
+    /* The most bytes a frame takes, a literal token per 64 words. */
+    static const size_t FRAME_SIZE_MAX = 3 + WORDS_NB * 4 + WORDS_NB / 64;
+
+    enum Op {
+        Skip = 0,
+        Run = 1,
+        Literal = 2,
+    };
+
+    #define FRAME_DECODER_IS_INTRA_MASK     ((u8)(1 << 0))
+    #define FRAME_DECODER_IS_REFERENCE_MASK ((u8)(1 << 1))
+    #define FRAME_DECODER_OP_SHIFT          6
+    #define FRAME_DECODER_NB_MASK           ((u8)((1 << FRAME_DECODER_OP_SHIFT) - 1))
+
+    FrameDecoder(const u8 *pd, size_t sz):
+        data(pd),
+        size(sz),
+        offset(0),
+        framesNb(0) {
+        /* Walk the tokens once, for the number of frames. */
+        while (offset < size) {
+            skipFrame();
+            ++framesNb;
+        }
+        offset = 0;
+    }
+
+    inline
+    void rewind() {
+        /* Make the first frame the next one to decode. */
+        offset = 0;
+    }
+
+    inline
+    int decode(u32 frame[WORDS_NB]) {
+        /*
+         * Decode the next frame into frame, which must hold the previous one,
+         * and return its delay. Past the last frame it starts over from the
+         * first one, which is always an intra frame.
+         */
+        if (offset >= size)
+            offset = 0;
+
+        u8 flags = data[offset];
+        int delay = data[offset + 1] | (data[offset + 2] << 8);
+        offset += 3;
+
+        if (flags & FRAME_DECODER_IS_REFERENCE_MASK) {
+            size_t target = data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16);
+            offset += 3;
+
+            /* Decode the tokens of the referenced frame, then carry on here. */
+            size_t next = offset;
+            offset = target + 3;
+            memset(frame, 0, WORDS_NB * sizeof(u32));
+            decodeTokens(&data[offset], size - offset, frame);
+            offset = next;
+        }
+        else {
+            if (flags & FRAME_DECODER_IS_INTRA_MASK)
+                memset(frame, 0, WORDS_NB * sizeof(u32));
+            offset += decodeTokens(&data[offset], size - offset, frame);
+        }
+
+        return delay;
+    }
+
+    inline
+    size_t getFramesNb() const {
+        return framesNb;
+    }
+
+    /*
+     * Decode the tokens of a frame, of the size bytes at tokens, over frame
+     * and return the number of bytes they took. The words past a token cut
+     * short by size stay as they are.
+     */
+    static inline
+    size_t decodeTokens(const u8 *tokens, size_t size, u32 frame[WORDS_NB]) {
+        size_t offset = 0;
+        int word = 0;
+        while (word < WORDS_NB && offset < size) {
+            u8 token = tokens[offset++];
+            int nb = (token & FRAME_DECODER_NB_MASK) + 1;
+            if (nb > WORDS_NB - word)
+                nb = WORDS_NB - word;
+
+            switch (token >> FRAME_DECODER_OP_SHIFT) {
+            case Run: {
+                if (size - offset < 4)
+                    return size;
+                u32 value = readWord(&tokens[offset]);
+                offset += 4;
+                for (int i = 0; i < nb; ++i)
+                    frame[word + i] = value;
+                break;
+            }
+
+            case Literal:
+                if (size - offset < 4 * (size_t)nb)
+                    return size;
+                for (int i = 0; i < nb; ++i, offset += 4)
+                    frame[word + i] = readWord(&tokens[offset]);
+                break;
+
+            default:
+                break;
+            }
+            word += nb;
+        }
+        return offset;
+    }
+
+private:
+    static inline
+    u32 readWord(const u8 *p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+    }
+
+    inline
+    void skipFrame() {
+        u8 flags = data[offset];
+        offset += 3;
+
+        if (flags & FRAME_DECODER_IS_REFERENCE_MASK) {
+            offset += 3;
+            return;
+        }
+
+        int word = 0;
+        while (word < WORDS_NB && offset < size) {
+            u8 token = data[offset++];
+            int nb = (token & FRAME_DECODER_NB_MASK) + 1;
+
+            switch (token >> FRAME_DECODER_OP_SHIFT) {
+            case Run:
+                offset += 4;
+                break;
+
+            case Literal:
+                offset += 4 * nb;
+                break;
+
+            default:
+                break;
+            }
+            word += nb;
+        }
+    }
+
+    const u8        *data;
+        /* The packed frames. */
+
+    size_t          size;
+        /* Number of bytes in data. */
+
+    size_t          offset;
+        /* Offset of the header of the next frame in data. */
+
+    size_t          framesNb;
+        /* Number of frames in data. */
+
+    /* No default construction. */
+    FrameDecoder() {};
+};
+
+#endif // FRAME_DECODER_HPP
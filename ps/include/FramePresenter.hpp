@@ -0,0 +1,309 @@
+#ifndef FRAME_PRESENTER_HPP
+#define FRAME_PRESENTER_HPP
+
+#include <string.h>
+#include "xil_types.h"
+
+/*
+ * FramePresenter keeps a copy of the frame that was last pushed to GDDRAM and,
+ * for every next frame, sends only the page/column windows that have changed.
+ *
+ * Frames are 128 u32 words in the page-major layout produced by xbm2bin, i.e.
+ * 4 pages of 32 words, each word carrying 4 consecutive columns (MSB first).
+ * The diff is done with word granularity, so windows always start and end on
+ * a 4-column boundary.
+ *
+ * Cost model: every SPI transfer costs its bytes plus TRANSFER_COST for the
+ * AXI round-trips and the CS/start-up overhead of the driver. Setting up
+ * a window takes 6 one-byte command transfers (ColumnAddress and PageAddress,
+ * each with two arguments), a data word takes a single 4-byte transfer.
+ * Gaps between dirty runs on the same page are bridged when sending the
+ * unchanged words is cheaper than opening another window, and the resulting
+ * per-page windows are replaced with a single bounding-box window (which is a
+ * full push when everything has changed) if that turns out to be cheaper.
+ *
+ * The words sent to the display are taken from shown, not from next, so the
+ * caller can reuse next, e.g. decode the following frame into it, as soon as
+ * present() returns.
+ *
+ * Double buffered, the frames go to the off-screen half of the 64 rows of
+ * GDDRAM (the panel shows 32 of them), which is then flipped on screen with
+ * a single DisplayStartLine command queued after the data. A frame never
+ * shows up half written, at the cost of diffing against the frame before
+ * the last one, which is what the off-screen half still holds.
+ *
+ * present() is stage(), which sends the frame, followed by flip(). Calling
+ * them apart lets several panels flip at once, each once its frame is in.
+ *
+ * Display is an Ssd1306 instantiation.
+ */
+template <class Display>
+class FramePresenter {
+
+public:
+    static const int COLUMNS_NB = 128;
+    static const int PAGES_NB = 4;
+    static const int COLUMNS_PER_WORD = 4;
+    static const int WORDS_PER_PAGE = COLUMNS_NB / COLUMNS_PER_WORD;
+    static const int WORDS_NB = PAGES_NB * WORDS_PER_PAGE;
+
+    static const int TRANSFER_COST = 1;
+    static const int WORD_COST = COLUMNS_PER_WORD + TRANSFER_COST;
+    static const int WINDOW_COST = 6 * (1 + TRANSFER_COST);
+
+    FramePresenter(Display *dp):
+        display(dp),
+        isDoubleBuffered(false),
+        visibleHalf(0),
+        stagedHalf(0),
+        isStartLineValid(false),
+        bytesNb(0) {
+        memset(shown, 0, sizeof(shown));
+        isShownValid[0] = false;
+        isShownValid[1] = false;
+    }
+
+    inline
+    void invalidate() {
+        /*
+         * Forget what is on the display, e.g. after it has been power cycled.
+         * The next present() will push the whole frame, and set the start
+         * line when double buffered.
+         */
+        isShownValid[0] = false;
+        isShownValid[1] = false;
+        isStartLineValid = false;
+    }
+
+    inline
+    void setDoubleBuffered(bool isOn) {
+        isDoubleBuffered = isOn;
+        invalidate();
+    }
+
+    inline
+    int getFirstVisiblePage() const {
+        /* The GDDRAM page that is on the top row of the panel. */
+        return visibleHalf * PAGES_NB;
+    }
+
+    inline
+    void present(const u32 next[WORDS_NB]) {
+        stage(next);
+        flip();
+    }
+
+    inline
+    void stage(const u32 next[WORDS_NB]) {
+        /*
+         * Send next to the off-screen half, or straight to the visible rows
+         * unless double buffered. It shows up with the following flip(),
+         * which has to come before the next stage().
+         */
+        Window windows[PAGES_NB * WORDS_PER_PAGE / 2 + 1];
+        int windowsNb = 0;
+        int windowsCost = 0;
+
+        /* The half of GDDRAM the frame goes to. */
+        int half = isDoubleBuffered ? 1 - visibleHalf : 0;
+        u32 *target = shown[half];
+        bool isFullPush = !isShownValid[half];
+
+        if (isDoubleBuffered && isStartLineValid && isShownValid[visibleHalf] &&
+                memcmp(next, shown[visibleHalf], sizeof(shown[0])) == 0) {
+            /* Already on screen. */
+            stagedHalf = visibleHalf;
+            bytesNb = 0;
+            return;
+        }
+        stagedHalf = half;
+
+        /* Bounding box of all changes. */
+        int firstPage = PAGES_NB, lastPage = -1;
+        int firstWord = WORDS_PER_PAGE, lastWord = -1;
+
+        if (isFullPush) {
+            firstPage = 0;
+            lastPage = PAGES_NB - 1;
+            firstWord = 0;
+            lastWord = WORDS_PER_PAGE - 1;
+        }
+        else {
+            for (int page = 0; page < PAGES_NB; ++page) {
+                const u32 *n = &next[page * WORDS_PER_PAGE];
+                u32 *s = &target[page * WORDS_PER_PAGE];
+
+                int word = 0;
+                while (word < WORDS_PER_PAGE) {
+                    /* Skip the unchanged words. */
+                    while (word < WORDS_PER_PAGE && n[word] == s[word])
+                        ++word;
+                    if (word == WORDS_PER_PAGE)
+                        break;
+
+                    int first = word;
+                    int last = word;
+                    int gap = 0;
+                    for (++word; word < WORDS_PER_PAGE; ++word) {
+                        if (n[word] != s[word]) {
+                            last = word;
+                            gap = 0;
+                        }
+                        else if (++gap * WORD_COST > WINDOW_COST) {
+                            /* Cheaper to open another window than to bridge. */
+                            break;
+                        }
+                    }
+                    word = last + 1;
+
+                    Window *w = &windows[windowsNb++];
+                    w->page = page;
+                    w->firstWord = first;
+                    w->lastWord = last;
+                    windowsCost += WINDOW_COST + (last - first + 1) * WORD_COST;
+
+                    if (page < firstPage)
+                        firstPage = page;
+                    lastPage = page;
+                    if (first < firstWord)
+                        firstWord = first;
+                    if (last > lastWord)
+                        lastWord = last;
+                }
+            }
+
+            /* Nothing has changed, and the half is the visible one already. */
+            if (windowsNb == 0 && half == visibleHalf && isStartLineValid) {
+                bytesNb = 0;
+                return;
+            }
+        }
+
+        int boxCost =
+            WINDOW_COST +
+            (lastPage - firstPage + 1) * (lastWord - firstWord + 1) * WORD_COST;
+
+        /* The DMA of the previous frame may still be reading shown. */
+        display->waitForDmaDone();
+        memcpy(target, next, sizeof(shown[0]));
+        isShownValid[half] = true;
+
+        /* The off-screen half may hold the frame already, then it is a flip. */
+        bytesNb = 0;
+        if (isFullPush || boxCost <= windowsCost) {
+            if (isFullPush || windowsNb > 0)
+                sendWindow(half, firstPage, lastPage, firstWord, lastWord);
+        }
+        else {
+            for (int i = 0; i < windowsNb; ++i) {
+                Window *w = &windows[i];
+                sendWindow(half, w->page, w->page, w->firstWord, w->lastWord);
+            }
+        }
+    }
+
+    inline
+    void flip() {
+        /* Show what was staged last, the command goes out after its data. */
+        if (stagedHalf != visibleHalf || !isStartLineValid) {
+            batch.clear();
+            batch.add((typename Display::Command)(Display::DisplayStartLine + stagedHalf * PAGES_NB * 8));
+            display->submit(batch);
+            visibleHalf = stagedHalf;
+            isStartLineValid = true;
+            bytesNb += 1;
+        }
+    }
+
+    inline
+    size_t getBytesNb() const {
+        /* Number of bytes that went over SPI for the last presented frame. */
+        return bytesNb;
+    }
+
+private:
+    struct Window {
+        int page;
+        int firstWord;
+        int lastWord;
+    };
+
+    inline
+    void sendWindow(int half, int firstPage, int lastPage, int firstWord, int lastWord) {
+        const u32 *frame = shown[half];
+        int wordsNb = lastWord - firstWord + 1;
+
+        /*
+         * Everything goes through the TX FIFO of the driver, present() returns
+         * as soon as the last word is queued or the DMA is started, so shown
+         * must not change until the display has caught up with it.
+         */
+        batch.clear();
+        batch.add(
+            Display::ColumnAddress,
+            firstWord * COLUMNS_PER_WORD,
+            (lastWord + 1) * COLUMNS_PER_WORD - 1
+        );
+        batch.add(
+            Display::PageAddress,
+            half * PAGES_NB + firstPage,
+            half * PAGES_NB + lastPage
+        );
+
+        /*
+         * With the horizontal addressing mode the pointer wraps to the next
+         * page at the end of the column window, so the rows of the box go out
+         * back to back. A box that spans whole pages is contiguous in shown and
+         * is left for the driver to fetch by itself.
+         */
+        if (wordsNb == WORDS_PER_PAGE) {
+            display->submit(batch);
+            display->startDma(
+                &frame[firstPage * WORDS_PER_PAGE],
+                (lastPage - firstPage + 1) * WORDS_PER_PAGE
+            );
+        }
+        else {
+            for (int page = firstPage; page <= lastPage; ++page)
+                batch.add(&frame[page * WORDS_PER_PAGE + firstWord], wordsNb);
+            display->submit(batch);
+        }
+
+        bytesNb += 6 + (lastPage - firstPage + 1) * wordsNb * COLUMNS_PER_WORD;
+    }
+
+    Display         *display;
+        /* The display the frames are presented on. */
+
+    u32             shown[2][WORDS_NB];
+        /*
+         * Copies of the frames held in the two halves of GDDRAM, only the
+         * first one is used unless double buffered.
+         */
+
+    bool            isShownValid[2];
+        /* Whether shown reflects GDDRAM, false until the first full push. */
+
+    bool            isDoubleBuffered;
+        /* Whether frames go to the off-screen half and get flipped. */
+
+    int             visibleHalf;
+        /* The half of GDDRAM the start line points at. */
+
+    int             stagedHalf;
+        /* The half of GDDRAM that the last stage() went to. */
+
+    bool            isStartLineValid;
+        /* Whether the start line is known to point at visibleHalf. */
+
+    size_t          bytesNb;
+        /* Number of SPI bytes of the last present(), or stage() and flip(). */
+
+    typename Display::Batch batch;
+        /* The commands and data of the window being sent. */
+
+    /* No default construction. */
+    FramePresenter() {};
+};
+
+#endif // FRAME_PRESENTER_HPP
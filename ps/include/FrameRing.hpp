@@ -0,0 +1,222 @@
+#ifndef FRAME_RING_HPP
+#define FRAME_RING_HPP
+
+#include <string.h>
+#include "xil_types.h"
+
+/*
+ * The line size of the data cache, the Cortex-A9 L1 has 32-byte lines. The
+ * host stress harness builds with 64.
+ */
+#ifndef FRAME_RING_CACHE_LINE_SIZE
+#define FRAME_RING_CACHE_LINE_SIZE 32
+#endif
+
+/*
+ * FrameRing hands frames from a single producer, e.g. a task rendering them
+ * procedurally, to a single consumer, which presents them, without locks and
+ * without copying them: the producer renders right into the slot it gets from
+ * acquire() and queues it with publish(), the consumer presents it out of the
+ * slot it gets from take() and hands it back with release().
+ *
+ * When all SLOTS_NB slots are queued, the policy decides:
+ *
+ *   Backpressure    - acquire() returns 0, the producer has to retry later,
+ *   OverwriteOldest - the oldest frame is dropped to make room, unless the
+ *                     consumer has taken it already, then acquire() returns 0
+ *                     until it is released. The producer is never held up
+ *                     then, it has to leave the consumer its turn, e.g. by
+ *                     rendering at a frame rate, on a single core above all.
+ *
+ * The slots and the two sides' indices are each on their own cache lines, so
+ * the sides only share the lines of the frames they hand over. The producer
+ * writes head and the consumer tail, but for dropping, which is a
+ * compare-and-swap of tail. Taking sets the held bit of tail in a single
+ * atomic or, which fails the drop in flight if any, so a frame is either
+ * dropped or taken, never both, and the consumer gets the oldest frame at its
+ * first attempt however fast the producer drops.
+ *
+ * SLOTS_NB must be a power of 2.
+ */
+template <u32 SLOTS_NB>
+class FrameRing {
+
+public:
+    static const int WORDS_NB = 128;
+
+    enum Policy {
+        Backpressure,
+        OverwriteOldest,
+    };
+
+    struct Slot {
+        u32         frame[WORDS_NB];
+            /* The frame, in the layout of FramePresenter. */
+
+        int         delay;
+            /* How long it stays [ms]. */
+    } __attribute__((aligned(FRAME_RING_CACHE_LINE_SIZE)));
+
+    /*
+     * What the ring went through, each side counts its own. The queued
+     * frames are counted as a publish() leaves them, the one being taken
+     * included.
+     */
+    struct Stats {
+        u32         publishedNb;
+        u32         droppedNb;
+            /* Frames overwritten before being taken. */
+        u32         rejectedNb;
+            /* acquire() calls that found the ring full. */
+        u32         takenNb;
+        u32         emptyNb;
+            /* take() calls that found the ring empty. */
+        u32         maxQueuedNb;
+        u32         queuedHistogram[SLOTS_NB + 1];
+            /* Number of publish() calls that left i frames queued. */
+    };
+
+    FrameRing(Policy p = Backpressure):
+        policy(p),
+        head(0),
+        tail(0),
+        takenNb(0),
+        emptyNb(0) {
+        static_assert((SLOTS_NB & (SLOTS_NB - 1)) == 0, "SLOTS_NB is not a power of 2");
+        memset(slots, 0, sizeof(slots));
+        memset(&producerStats, 0, sizeof(producerStats));
+    }
+
+    inline
+    Slot *acquire() {
+        /*
+         * The producer side. The slot to render the next frame into, or 0
+         * when there is none, see Policy. Until publish() the same slot comes
+         * back.
+         */
+        u32 h = head;
+        while (true) {
+            u32 t = tail;
+            if (((h - (t >> COUNT_SHIFT)) & COUNT_MASK) < SLOTS_NB)
+                break;
+
+            if (policy == Backpressure || (t & IS_HELD_MASK)) {
+                ++producerStats.rejectedNb;
+                return 0;
+            }
+
+            /* Drop the oldest frame, unless the consumer has taken it now. */
+            if (__sync_bool_compare_and_swap(&tail, t, t + (1 << COUNT_SHIFT)))
+                ++producerStats.droppedNb;
+        }
+
+        /* The consumer is done with the slot before it gets written. */
+        __sync_synchronize();
+        return &slots[h % SLOTS_NB];
+    }
+
+    inline
+    void publish() {
+        /* Queue the slot of the last acquire(), with its frame rendered. */
+        __sync_synchronize();
+        u32 h = (head + 1) & COUNT_MASK;
+        head = h;
+
+        u32 queuedNb = (h - (tail >> COUNT_SHIFT)) & COUNT_MASK;
+        if (queuedNb > SLOTS_NB)
+            queuedNb = SLOTS_NB;
+        ++producerStats.publishedNb;
+        ++producerStats.queuedHistogram[queuedNb];
+        if (queuedNb > producerStats.maxQueuedNb)
+            producerStats.maxQueuedNb = queuedNb;
+    }
+
+    inline
+    const Slot *take() {
+        /*
+         * The consumer side. The oldest frame queued, or 0 when there is
+         * none. It stays put until release(), which has to come before the
+         * next take().
+         */
+        if ((tail >> COUNT_SHIFT) == head) {
+            ++emptyNb;
+            return 0;
+        }
+
+        /*
+         * The producer leaves tail alone once it is held, the frames it
+         * dropped up to then are the ones skipped.
+         */
+        u32 t = __sync_fetch_and_or(&tail, IS_HELD_MASK);
+        if ((t >> COUNT_SHIFT) == head) {
+            /* With a single slot, the frame may have been dropped since. */
+            tail = t;
+            ++emptyNb;
+            return 0;
+        }
+
+        ++takenNb;
+        return &slots[(t >> COUNT_SHIFT) % SLOTS_NB];
+    }
+
+    inline
+    void release() {
+        /* Hand the slot of the last take() back to the producer. */
+        __sync_synchronize();
+
+        /* The producer leaves tail alone while a slot is held. */
+        u32 t = tail;
+        tail = ((((t >> COUNT_SHIFT) + 1) & COUNT_MASK) << COUNT_SHIFT);
+    }
+
+    inline
+    u32 getQueuedNb() const {
+        /* Number of frames queued, the one taken included. */
+        return (head - (tail >> COUNT_SHIFT)) & COUNT_MASK;
+    }
+
+    inline
+    Stats getStats() const {
+        /* Both sides' counts, as they are while the sides go on. */
+        Stats stats = producerStats;
+        stats.takenNb = takenNb;
+        stats.emptyNb = emptyNb;
+        return stats;
+    }
+
+    inline
+    void setPolicy(Policy p) {
+        policy = p;
+    }
+
+private:
+    /*
+     * tail holds the number of the frames dropped or released, shifted by
+     * COUNT_SHIFT, and whether the oldest one is taken. The numbers wrap
+     * around at COUNT_MASK.
+     */
+    static const u32 IS_HELD_MASK = 1;
+    static const int COUNT_SHIFT = 1;
+    static const u32 COUNT_MASK = 0x7FFFFFFF;
+
+    Slot            slots[SLOTS_NB];
+        /* Frame i is in slot i % SLOTS_NB. */
+
+    volatile Policy policy;
+        /* What acquire() does when the ring is full. */
+
+    volatile u32    head __attribute__((aligned(FRAME_RING_CACHE_LINE_SIZE)));
+        /* Number of frames published, written by the producer. */
+
+    Stats           producerStats;
+        /* The producer's counts, the consumer's ones left out. */
+
+    volatile u32    tail __attribute__((aligned(FRAME_RING_CACHE_LINE_SIZE)));
+        /* See above, written by the consumer, and by the producer to drop. */
+
+    u32             takenNb;
+    u32             emptyNb;
+        /* The consumer's counts. */
+};
+
+#endif // FRAME_RING_HPP
@@ -0,0 +1,248 @@
+#ifndef FRAME_STREAM_HPP
+#define FRAME_STREAM_HPP
+
+#include <stddef.h>
+#include <string.h>
+#include "xil_types.h"
+#include "FrameDecoder.hpp"
+
+/*
+ * FrameStream plays back an animation container, as written by
+ * utils/framepack -c, fetching the frames from Storage as they get decoded,
+ * so no more than READ_AHEAD_SIZE bytes of the animation are in RAM at a time,
+ * and none of it needs to be in the image.
+ *
+ * A container is little endian:
+ *
+ *   header   - "OLAN", the version (u16), the number of frames (u16), the
+ *              offsets of the index and of the payloads (u32) and the size of
+ *              the payloads (u32),
+ *   index    - an entry per frame: the offset of its payload from the start of
+ *              the payloads (u32), its size (u16) and its delay [ms] (u16),
+ *   payloads - the frames as FrameDecoder reads them, the offsets that the
+ *              reference frames carry count from the start of the payloads.
+ *
+ * Storage is anything with
+ *
+ *   bool read(u32 offset, void *out, size_t size) const;
+ *
+ * that copies the size bytes at offset to out and says whether it got them
+ * all, e.g. MemoryStorage, or FileStorage on the host.
+ *
+ * The container is opened with the first call that needs it, an animation
+ * costs nothing but the read-ahead buffers until it gets played.
+ */
+template <class Storage>
+class FrameStream {
+
+public:
+    static const int WORDS_NB = FrameDecoder::WORDS_NB;
+    static const u16 VERSION = 1;
+    static const size_t HEADER_SIZE = 20;
+    static const size_t ENTRY_SIZE = 8;
+
+    /* The bytes of payloads read at a time, the frame needed and what follows. */
+    static const size_t READ_AHEAD_SIZE = 1024;
+
+    /* The index entries read at a time. */
+    static const size_t ENTRIES_AHEAD_NB = 16;
+
+    FrameStream(const Storage &s):
+        storage(s),
+        isOpen(false),
+        framesNb(0),
+        indexOffset(0),
+        payloadsOffset(0),
+        payloadsSize(0),
+        frameIdx(0),
+        firstEntryIdx(0),
+        entriesNb(0),
+        windowOffset(0),
+        windowSize(0) {
+    }
+
+    inline
+    void rewind() {
+        /* Make the first frame the next one to decode. */
+        frameIdx = 0;
+    }
+
+    inline
+    int decode(u32 frame[WORDS_NB]) {
+        /*
+         * Decode the next frame into frame, which must hold the previous one,
+         * and return its delay, or -1 when the container cannot be read, then
+         * frame stays as it is. Past the last frame it starts over from the
+         * first one, which is always an intra frame.
+         */
+        if (!open())
+            return -1;
+        if (frameIdx >= framesNb)
+            frameIdx = 0;
+
+        u32 offset;
+        u16 size;
+        u16 delay;
+        if (!readEntry(frameIdx, &offset, &size, &delay) || size < 3)
+            return -1;
+
+        const u8 *p = fetch(offset, size);
+        if (p == 0)
+            return -1;
+
+        u8 flags = p[0];
+        if (flags & FRAME_DECODER_IS_REFERENCE_MASK) {
+            if (size < 6)
+                return -1;
+            u32 target = p[3] | (p[4] << 8) | (p[5] << 16);
+
+            /*
+             * The referenced frame has to be an intra one, whatever its size,
+             * it is within FRAME_SIZE_MAX.
+             */
+            if (target >= payloadsSize)
+                return -1;
+            size = payloadsSize - target < FrameDecoder::FRAME_SIZE_MAX ?
+                payloadsSize - target : FrameDecoder::FRAME_SIZE_MAX;
+            p = fetch(target, size);
+            if (p == 0 || size < 3)
+                return -1;
+            if ((p[0] & (FRAME_DECODER_IS_INTRA_MASK | FRAME_DECODER_IS_REFERENCE_MASK)) !=
+                    FRAME_DECODER_IS_INTRA_MASK)
+                return -1;
+
+            memset(frame, 0, WORDS_NB * sizeof(u32));
+        }
+        else if (flags & FRAME_DECODER_IS_INTRA_MASK) {
+            memset(frame, 0, WORDS_NB * sizeof(u32));
+        }
+
+        FrameDecoder::decodeTokens(p + 3, size - 3, frame);
+        ++frameIdx;
+        return delay;
+    }
+
+    inline
+    size_t getFramesNb() {
+        /* Number of frames, 0 when the container cannot be read. */
+        open();
+        return framesNb;
+    }
+
+private:
+    static inline
+    u16 readU16(const u8 *p) {
+        return p[0] | (p[1] << 8);
+    }
+
+    static inline
+    u32 readU32(const u8 *p) {
+        return readU16(p) | ((u32)readU16(p + 2) << 16);
+    }
+
+    inline
+    bool open() {
+        /* Read the header, unless that has been done already. */
+        if (isOpen)
+            return true;
+
+        u8 header[HEADER_SIZE];
+        if (!storage.read(0, header, sizeof(header)) ||
+                memcmp(header, "OLAN", 4) != 0 ||
+                readU16(&header[4]) != VERSION ||
+                readU16(&header[6]) == 0)
+            return false;
+
+        framesNb = readU16(&header[6]);
+        indexOffset = readU32(&header[8]);
+        payloadsOffset = readU32(&header[12]);
+        payloadsSize = readU32(&header[16]);
+        isOpen = true;
+        return true;
+    }
+
+    inline
+    bool readEntry(size_t idx, u32 *offset, u16 *size, u16 *delay) {
+        /* The index entry of frame idx, read ahead with the ones after it. */
+        if (idx < firstEntryIdx || idx >= firstEntryIdx + entriesNb) {
+            size_t nb = framesNb - idx < ENTRIES_AHEAD_NB ? framesNb - idx : ENTRIES_AHEAD_NB;
+            entriesNb = 0;
+            if (!storage.read(indexOffset + idx * ENTRY_SIZE, entries, nb * ENTRY_SIZE))
+                return false;
+            firstEntryIdx = idx;
+            entriesNb = nb;
+        }
+
+        const u8 *entry = &entries[(idx - firstEntryIdx) * ENTRY_SIZE];
+        *offset = readU32(&entry[0]);
+        *size = readU16(&entry[4]);
+        *delay = readU16(&entry[6]);
+        return true;
+    }
+
+    inline
+    const u8 *fetch(u32 offset, size_t size) {
+        /*
+         * The size bytes of the payloads at offset, read ahead with the ones
+         * after them unless they are in the window already, or 0 when they
+         * cannot be read.
+         */
+        if (offset >= windowOffset && offset - windowOffset + size <= windowSize)
+            return &window[offset - windowOffset];
+
+        if (size > READ_AHEAD_SIZE || offset > payloadsSize || size > payloadsSize - offset)
+            return 0;
+
+        size_t nb = payloadsSize - offset < READ_AHEAD_SIZE ? payloadsSize - offset : READ_AHEAD_SIZE;
+        windowSize = 0;
+        if (!storage.read(payloadsOffset + offset, window, nb))
+            return 0;
+        windowOffset = offset;
+        windowSize = nb;
+        return window;
+    }
+
+    Storage         storage;
+        /* Where the container is. */
+
+    bool            isOpen;
+        /* Whether the header has been read. */
+
+    size_t          framesNb;
+        /* Number of frames in the container. */
+
+    u32             indexOffset;
+        /* Offset of the index in storage. */
+
+    u32             payloadsOffset;
+        /* Offset of the payloads in storage. */
+
+    u32             payloadsSize;
+        /* Number of bytes of the payloads. */
+
+    size_t          frameIdx;
+        /* Index of the frame to decode next. */
+
+    u8              entries[ENTRIES_AHEAD_NB * ENTRY_SIZE];
+        /* The index entries read ahead... */
+
+    size_t          firstEntryIdx;
+        /* ... from this one on... */
+
+    size_t          entriesNb;
+        /* ... this many of them. */
+
+    u8              window[READ_AHEAD_SIZE];
+        /* The payloads read ahead... */
+
+    u32             windowOffset;
+        /* ... from this offset on... */
+
+    size_t          windowSize;
+        /* ... this many bytes of them. */
+
+    /* No default construction. */
+    FrameStream() {};
+};
+
+#endif // FRAME_STREAM_HPP
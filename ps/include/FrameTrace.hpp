@@ -0,0 +1,187 @@
+#ifndef FRAME_TRACE_HPP
+#define FRAME_TRACE_HPP
+
+#include <string.h>
+#include "xil_types.h"
+
+/*
+ * FrameTrace keeps what it took to show the last RECORDS_NB frames, for
+ * finding out where the time of a frame goes and how far the frames drift
+ * from their delays.
+ *
+ * There is a single writer, the code that shows the frames, and a single
+ * reader, which copies the records out and leaves the writer alone: the
+ * writer never waits, it overwrites the oldest record, and the reader drops
+ * whatever got overwritten while it was copying.
+ *
+ * The times are in microseconds, of whatever clock the writer reads, e.g. the
+ * global timer of the Cortex-A9 (XTime_GetTime()), FrameTrace only sorts and
+ * counts them.
+ */
+class FrameTrace {
+
+public:
+    static const u32 RECORDS_NB = 256;
+    static const int BUCKETS_NB = 16;
+
+    struct Record {
+        u32         sendUs;
+            /* The time it took to get the frame to the display. */
+
+        u32         lateUs;
+            /* The time the frame started past its due time, 0 when it was
+             * not late or had none. */
+
+        u16         waitsNb;
+            /* Number of times the render tasks blocked on the display IRQ. */
+
+        u16         bytesNb;
+            /* Number of bytes of the frame sent to the display. */
+    };
+
+    enum Field {
+        SendUs,
+        LateUs,
+        WaitsNb,
+        BytesNb,
+    };
+
+    /*
+     * The distribution of a field of the records. Bucket 0 of the histogram
+     * counts the values of 0, bucket k > 0 those in [2^(k-1), 2^k), the last
+     * bucket everything above as well.
+     */
+    struct Summary {
+        u32         recordsNb;
+        u32         min;
+        u32         p50;
+        u32         p90;
+        u32         p99;
+        u32         max;
+        u32         histogram[BUCKETS_NB];
+    };
+
+    FrameTrace():
+        addedNb(0) {
+        memset(records, 0, sizeof(records));
+    }
+
+    inline
+    void add(const Record &record) {
+        /* The writer side. */
+        records[addedNb % RECORDS_NB] = record;
+
+        /* The record has to be in place before the reader can see it. */
+        __sync_synchronize();
+        addedNb = addedNb + 1;
+    }
+
+    /*
+     * Copy the records that are there, up to the last max, oldest first, to
+     * out, and return their number. The reader side.
+     */
+    inline
+    u32 copy(Record out[], u32 max) const {
+        u32 lastNb = addedNb;
+        __sync_synchronize();
+
+        u32 nb = lastNb < RECORDS_NB ? lastNb : RECORDS_NB;
+        if (nb > max)
+            nb = max;
+        u32 first = lastNb - nb;
+        for (u32 i = 0; i < nb; ++i)
+            out[i] = records[(first + i) % RECORDS_NB];
+
+        /*
+         * Drop the records the writer got to in the meantime, the one it may
+         * be writing right now included.
+         */
+        __sync_synchronize();
+        u32 overwrittenNb = addedNb + 1 - first;
+        if (overwrittenNb > RECORDS_NB) {
+            overwrittenNb -= RECORDS_NB;
+            if (overwrittenNb >= nb)
+                return 0;
+            memmove(out, out + overwrittenNb, (nb - overwrittenNb) * sizeof(Record));
+            nb -= overwrittenNb;
+        }
+        return nb;
+    }
+
+    inline
+    u32 getAddedNb() const {
+        /* Number of records added so far, overwritten ones included. */
+        return addedNb;
+    }
+
+    /*
+     * Summarize field of the nb records, values is for nb values of scratch.
+     */
+    static inline
+    void summarize(const Record records[], u32 nb, Field field, u32 values[],
+            Summary *summary) {
+        memset(summary, 0, sizeof(*summary));
+        summary->recordsNb = nb;
+        if (nb == 0)
+            return;
+
+        for (u32 i = 0; i < nb; ++i) {
+            values[i] = valueOf(records[i], field);
+            ++summary->histogram[bucketOf(values[i])];
+        }
+
+        /* Insertion sort, there are a few hundred values at the most. */
+        for (u32 i = 1; i < nb; ++i) {
+            u32 value = values[i];
+            u32 j = i;
+            for (; j > 0 && values[j - 1] > value; --j)
+                values[j] = values[j - 1];
+            values[j] = value;
+        }
+
+        summary->min = values[0];
+        summary->p50 = values[(nb - 1) * 50 / 100];
+        summary->p90 = values[(nb - 1) * 90 / 100];
+        summary->p99 = values[(nb - 1) * 99 / 100];
+        summary->max = values[nb - 1];
+    }
+
+    static inline
+    u32 getBucketLimit(int bucket) {
+        /* The values of bucket are below this, but for the last bucket. */
+        return 1u << bucket;
+    }
+
+private:
+    static inline
+    u32 valueOf(const Record &record, Field field) {
+        switch (field) {
+        case SendUs:
+            return record.sendUs;
+        case LateUs:
+            return record.lateUs;
+        case WaitsNb:
+            return record.waitsNb;
+        default:
+            return record.bytesNb;
+        }
+    }
+
+    static inline
+    int bucketOf(u32 value) {
+        int bucket = 0;
+        while (value > 0 && bucket < BUCKETS_NB - 1) {
+            value >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    Record          records[RECORDS_NB];
+        /* The ring, record i is at i % RECORDS_NB. */
+
+    volatile u32    addedNb;
+        /* Number of records added, the only thing both sides write/read. */
+};
+
+#endif // FRAME_TRACE_HPP
@@ -0,0 +1,37 @@
+#ifndef MEMORY_STORAGE_HPP
+#define MEMORY_STORAGE_HPP
+
+#include <stddef.h>
+#include <string.h>
+#include "xil_types.h"
+
+/*
+ * MemoryStorage is the Storage of FrameStream for size bytes that the CPU
+ * sees in memory: an array built into the image, or a region of the QSPI
+ * flash read in linear mode, from XPAR_PS7_QSPI_LINEAR_0_S_AXI_BASEADDR on,
+ * which takes no RAM and no room in the image.
+ */
+struct MemoryStorage {
+
+    MemoryStorage(const void *pd = 0, u32 sz = 0):
+        data((const u8 *)pd),
+        size(sz) {
+    }
+
+    inline
+    bool read(u32 offset, void *out, size_t nb) const {
+        if (offset > size || nb > size - offset)
+            return false;
+
+        memcpy(out, data + offset, nb);
+        return true;
+    }
+
+    const u8        *data;
+        /* Where the bytes are. */
+
+    u32             size;
+        /* Number of them. */
+};
+
+#endif // MEMORY_STORAGE_HPP
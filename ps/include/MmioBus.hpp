@@ -0,0 +1,70 @@
+#ifndef MMIO_BUS_HPP
+#define MMIO_BUS_HPP
+
+#include "xil_io.h"
+#include "xil_cache.h"
+
+/*
+ * Register access of an Ssd1306 driver on the board, BASE_ADDRESS is the base
+ * address of the IP (XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR).
+ */
+template <UINTPTR BASE_ADDRESS>
+struct MmioBus {
+
+    static inline
+    u32 read(u32 offset) {
+        return Xil_In32(BASE_ADDRESS + offset);
+    }
+
+    static inline
+    void write(u32 offset, u32 value) {
+        Xil_Out32(BASE_ADDRESS + offset, value);
+    }
+
+    static inline
+    u32 toBusAddress(const void *p) {
+        /* The PS has no MMU translation set up, addresses are physical. */
+        return (u32)(UINTPTR)p;
+    }
+
+    static inline
+    void flushForDevice(const void *p, u32 size) {
+        Xil_DCacheFlushRange((INTPTR)p, size);
+    }
+};
+
+/*
+ * MmioBus with the base address of the IP set at run time, one per instance
+ * of the IP.
+ */
+struct RuntimeMmioBus {
+
+    RuntimeMmioBus(UINTPTR ba = 0):
+        baseAddress(ba) {
+    }
+
+    inline
+    u32 read(u32 offset) const {
+        return Xil_In32(baseAddress + offset);
+    }
+
+    inline
+    void write(u32 offset, u32 value) const {
+        Xil_Out32(baseAddress + offset, value);
+    }
+
+    static inline
+    u32 toBusAddress(const void *p) {
+        return (u32)(UINTPTR)p;
+    }
+
+    static inline
+    void flushForDevice(const void *p, u32 size) {
+        Xil_DCacheFlushRange((INTPTR)p, size);
+    }
+
+    UINTPTR         baseAddress;
+        /* XPAR_SSD1306_DRIVER_<n>_S00_AXI_BASEADDR. */
+};
+
+#endif // MMIO_BUS_HPP
@@ -1,11 +1,16 @@
-#include "xil_io.h"
+#ifndef SSD1306_HPP
+#define SSD1306_HPP
+
+#include "xil_types.h"
 #include "ssd1306_driver.h"
 
 /*
  * The below shows layout of accessible data in AXI registers.
  *
  *  -> .slv_reg0(
- *          {{C_S00_AXI_DATA_WIDTH - 4{1'bZ}},
+ *          {slv_reg0_unused[C_S00_AXI_DATA_WIDTH - 7:0],
+ *          should_sleep,
+ *          should_stream,
  *          is_din_u8,
  *          is_din_data,
  *          should_send_din,
@@ -15,21 +20,186 @@
  *          din
 *       ),
  *  <- .slv_reg2(
- *          {{C_S00_AXI_DATA_WIDTH - 1{1'b0}},
+ *          {{C_S00_AXI_DATA_WIDTH - 7{1'b0}},
+ *          is_asleep,
+ *          is_fifo_over_half,
+ *          has_dma_failed,
+ *          is_dma_busy,
+ *          is_fifo_full,
+ *          is_fifo_draining,
  *          is_busy
 *      }),
+ *  -> .slv_reg3(
+ *          sclk_divider
+*       ),
+ *  -> .slv_reg4(
+ *          fifo_wdata
+*       ),
+ *  <- .slv_reg5({
+ *          fifo_space[31:16],
+ *          fifo_level[15:0]
+*      }),
+ *  -> .slv_reg6(
+ *          dma_addr
+*       ),
+ *  -> .slv_reg7(
+ *          dma_length
+*       ),
+ *  -> .slv_reg8(
+ *          irq_enable
+*       ),
+ *  <> .slv_reg9({
+ *          {{C_S00_AXI_DATA_WIDTH - 4{1'b0}},
+ *          fifo_half_empty,
+ *          dma_done,
+ *          fifo_drained,
+ *          send_done
+*      }),
+ *  -> .slv_reg10(
+ *          {{C_S00_AXI_DATA_WIDTH - 2{1'b0}},
+ *          should_clear,
+ *          should_snapshot
+*      }),
+ *  <- .slv_reg11(words_nb),
+ *  <- .slv_reg12(command_bytes_nb),
+ *  <- .slv_reg13(data_bytes_nb),
+ *  <- .slv_reg14(busy_cycles),
+ *  <- .slv_reg15(idle_cycles),
+ *  <- .slv_reg16(rom_cycles),
+ *  <- .slv_reg17(longest_gap_cycles),
+ *  -> .slv_reg18({
+ *          {{C_S00_AXI_DATA_WIDTH - 24{1'b0}},
+ *          script_addr[7:0],
+ *          script_instruction[15:0]
+*      }),
+ *  -> .slv_reg19(
+ *          script_run_addr
+*       ),
+ *
+ * Every write to slv_reg4 pushes an entry into the TX FIFO, the entry takes
+ * is_din_u8 and is_din_data as they are set in slv_reg0 at the time of the
+ * write. The driver sends the entries out in order whenever it is not busy
+ * with the din of slv_reg1.
+ *
+ * With should_stream set, the driver sends the FIFO entries in bursts: the next
+ * entry is shifted out right after the last bit of the previous one, with CS
+ * held low, for as long as there is one and it goes with the same D/C#.
+ * Without it every entry is a transfer of its own, with CS raised and a few
+ * cycles of handshake in between.
+ *
+ * Setting should_sleep while powered on has the driver send Display OFF and
+ * set is_asleep, clearing it sends Display ON and clears is_asleep. VDD, VCC
+ * and the configuration of the panel stay as they are, so do the contents of
+ * GDDRAM, which can be written while asleep. A power off clears is_asleep, the
+ * power on after it ends in sleep unless should_sleep has been cleared.
+ *
+ * Every write to slv_reg7 starts the DMA, which reads dma_length bytes from
+ * dma_addr over the M00_AXI port and pushes them into the TX FIFO as 32-bit
+ * data entries. The FIFO must not be written through slv_reg4 while is_dma_busy
+ * is set.
+ *
+ * An SCLK period takes sclk_divider[7:0] + 1 AXI clock cycles, 0 (the reset
+ * value) selects the SCLK_DIVIDER parameter of the IP and anything below 4
+ * counts as 4. The driver takes a new value over between transfers.
+ *
+ * The bits of slv_reg9 latch the falling edges of is_busy, is_fifo_draining,
+ * is_dma_busy and is_fifo_over_half respectively and are cleared by writing 1
+ * to them. The irq output is high while any of them is set and enabled in
+ * slv_reg8.
+ *
+ * slv_reg11-17 are snapshots of free-running performance counters, writing 1
+ * to should_snapshot of slv_reg10 takes them all at once, 1 to should_clear
+ * zeroes the counters (after the snapshot when both are written). The counters
+ * saturate instead of wrapping around, slv_reg10 reads a bit per counter, in
+ * the order of slv_reg11-17, that is set in the snapshot of a saturated one.
+ * See src/perf-counters.v for what they count.
+ *
+ * Every write to slv_reg18 stores an instruction in the 256-word script
+ * memory, every write to slv_reg19 pushes an entry into the TX FIFO that runs
+ * the script at script_run_addr[7:0] when its turn comes, i.e. after what was
+ * queued before it and before what is queued after it. See
+ * src/ssd1306-driver.v for the instructions. The FIFO must not be written
+ * through slv_reg19 while is_dma_busy is set either.
  */
 #define SHOULD_TURN_POWER_ON_MASK   ((u32)(1 << 0))
 #define SHOULD_SEND_DIN_MASK        ((u32)(1 << 1))
 #define IS_DIN_DATA_MASK            ((u32)(1 << 2))
 #define IS_DIN_U8_MASK              ((u32)(1 << 3))
+#define SHOULD_STREAM_MASK          ((u32)(1 << 4))
+#define SHOULD_SLEEP_MASK           ((u32)(1 << 5))
 #define IS_BUSY_MASK                ((u32)(1 << 0))
+#define IS_FIFO_DRAINING_MASK       ((u32)(1 << 1))
+#define IS_FIFO_FULL_MASK           ((u32)(1 << 2))
+#define IS_DMA_BUSY_MASK            ((u32)(1 << 3))
+#define HAS_DMA_FAILED_MASK         ((u32)(1 << 4))
+#define IS_FIFO_OVER_HALF_MASK      ((u32)(1 << 5))
+#define IS_ASLEEP_MASK              ((u32)(1 << 6))
+#define SEND_DONE_IRQ_MASK          ((u32)(1 << 0))
+#define FIFO_DRAINED_IRQ_MASK       ((u32)(1 << 1))
+#define DMA_DONE_IRQ_MASK           ((u32)(1 << 2))
+#define FIFO_HALF_EMPTY_IRQ_MASK    ((u32)(1 << 3))
+#define FIFO_LEVEL_MASK             ((u32)0xFFFF)
+#define FIFO_SPACE_SHIFT            16
+#define SCLK_DIVIDER_MASK           ((u32)0xFF)
+#define PERF_SNAPSHOT_MASK          ((u32)(1 << 0))
+#define PERF_CLEAR_MASK             ((u32)(1 << 1))
+#define PERF_WORDS_OVERFLOW_MASK    ((u32)(1 << 0))
+#define PERF_COMMAND_BYTES_OVERFLOW_MASK ((u32)(1 << 1))
+#define PERF_DATA_BYTES_OVERFLOW_MASK ((u32)(1 << 2))
+#define PERF_BUSY_OVERFLOW_MASK     ((u32)(1 << 3))
+#define PERF_IDLE_OVERFLOW_MASK     ((u32)(1 << 4))
+#define PERF_ROM_OVERFLOW_MASK      ((u32)(1 << 5))
+#define PERF_GAP_OVERFLOW_MASK      ((u32)(1 << 6))
+#define SCRIPT_ADDR_SHIFT           16
 
 
+/*
+ * The driver talks to the registers through Bus, a class with the (static or
+ * not) functions:
+ *
+ *  - u32 read(u32 offset) and void write(u32 offset, u32 value), which access
+ *    the register at offset,
+ *  - u32 toBusAddress(const void *p), which returns the address that the DMA
+ *    of the IP has to use for p,
+ *  - void flushForDevice(const void *p, u32 size), which makes the memory at
+ *    p visible to the DMA.
+ *
+ * Every driver has a copy of the Bus it was constructed with, so a Bus can
+ * tell the instances of the IP apart.
+ *
+ * MmioBus (MmioBus.hpp) is the one for the board, the base address of the IP
+ * is its template parameter, so every access compiles down to Xil_Out32()/
+ * Xil_In32() at a constant address. RuntimeMmioBus takes the base address at
+ * run time instead, for drivers of several instances of the IP that have to
+ * be of the same type, e.g. in an array.
+ */
+template <class Bus>
 class Ssd1306 {
 
 public:
-    
+    typedef void (*WaitFn)(void *context);
+    typedef bool (*CheckFn)(void *context, u8 divider);
+
+    static const u8 SCLK_DIVIDER_DEFAULT = 20;
+        /* The SCLK_DIVIDER parameter of the IP, ~4.8MHz SCLK at 100MHz. */
+
+    static const u8 SCLK_DIVIDER_MIN = 4;
+
+    static const int SCRIPT_WORDS_NB = 256;
+        /* The instructions the script memory of the IP holds. */
+
+    Ssd1306(const Bus &b = Bus()):
+        bus(b),
+        control(0),
+        fifoSpace(0),
+        isDmaPending(false),
+        isScrolling(false),
+        waitFn(0),
+        waitContext(0),
+        mmioReadsNb(0),
+        mmioWritesNb(0) {
+    }
+
     /*
      * The commands:
      *
@@ -97,9 +267,72 @@ public:
         VerticalScrollArea = 0xA3
     };
 
+    /*
+     * Hardware scrolling.
+     *
+     * Once activated, the controller moves the picture by itself, a column
+     * every interval frames over the pages firstPage to lastPage, plus
+     * verticalOffset rows with the vertical variant (verticalOffset > 0),
+     * within the rows given by fixedRowsNb and scrolledRowsNb. It costs
+     * nothing on the bus until scrolling is stopped. The vertical variant
+     * takes the datasheet's bounds for Set Vertical Scroll Area: the fixed
+     * and the scrolled rows fit in the multiplex ratio the ROM sets, 32
+     * rows, and a step is shorter than the scrolled rows.
+     */
+    enum ScrollDirection {
+        ScrollRight,
+        ScrollLeft
+    };
+
+    enum ScrollInterval {
+        Frames2 = 7,
+        Frames3 = 4,
+        Frames4 = 5,
+        Frames5 = 0,
+        Frames25 = 6,
+        Frames64 = 1,
+        Frames128 = 2,
+        Frames256 = 3
+    };
+
+    struct Scroll {
+        ScrollDirection direction;
+        u8              firstPage;
+        u8              lastPage;
+        ScrollInterval  interval;
+        u8              verticalOffset;
+            /* Rows per step, 0 for horizontal scrolling only. */
+        u8              fixedRowsNb;
+            /* Rows at the top that do not scroll vertically. */
+        u8              scrolledRowsNb;
+            /* Rows below them that do. */
+    };
+
+    /* The performance counters of the IP, cycles are of the AXI clock. */
+    struct PerfCounters {
+        u32             wordsNb;
+            /* Words shifted out, of 1 or 4 bytes. */
+        u32             commandBytesNb;
+        u32             dataBytesNb;
+        u32             busyCycles;
+            /* Cycles spent shifting bits out. */
+        u32             idleCycles;
+            /* Cycles powered on with nothing to shift, waiting for the CPU. */
+        u32             romCycles;
+            /* Cycles spent running the power on/off ROM or a script. */
+        u32             longestGapCycles;
+            /* The longest time between two words since the clear. */
+        u32             overflows;
+            /* The PERF_*_OVERFLOW_MASK bits of the counters that saturated,
+             * their values are meaningless then. */
+    };
+
     inline
     void powerOn() {
-        /* Power the display on. */
+        /*
+         * Power the display on, from cold, which takes ~400ms, or wake it up
+         * when it is asleep, see sleep().
+         */
 
         /*
          * The sequence of commands that are sent to the chip when should_turn_power_on
@@ -121,14 +354,13 @@ public:
          *  15. 0000, (Sequential COM pins, Disable COM Left/Right remap)
          *  16. 0020, MemoryAddressingMode
          *  17. 0000, (Horizontal Addressing Mode)
-         *  18. 32AF, Display ON, wait 50*4ms
+         *  18. 00A8, MultiplexRatio:
+         *  19. 001F, (32 rows, the panel's COM0-COM31)
+         *  20. 0040, DisplayStartLine 0 (rows 32-63 are the off-screen half)
+         *  21. 32AF, Display ON, wait 50*4ms
          */
 
-        SSD1306_DRIVER_mWriteReg(
-            XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-            SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET,
-            SHOULD_TURN_POWER_ON_MASK
-        );
+        writeControl((control & SHOULD_STREAM_MASK) | SHOULD_TURN_POWER_ON_MASK);
     }
 
     inline
@@ -143,80 +375,113 @@ public:
          *   3. 4001; VDD 1 (active low), no wait
          */
 
-        SSD1306_DRIVER_mWriteReg(
-            XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-            SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET,
-            ~SHOULD_TURN_POWER_ON_MASK & ~SHOULD_SEND_DIN_MASK
-        );
+        writeControl(control & SHOULD_STREAM_MASK);
+        isScrolling = false;
+    }
+
+    /*
+     * Sleeping.
+     *
+     * A display that is asleep is blank, but stays powered on: the driver
+     * only sends Display OFF, and Display ON to resume, a single command
+     * rather than the ~400ms of the power on sequence. GDDRAM keeps its
+     * contents, and takes writes as usual, so a frame can be staged while
+     * asleep to come up with the resume.
+     */
+    inline
+    int sleep() {
+        /* Return 0, or -1 when the display is off. */
+        if (!(control & SHOULD_TURN_POWER_ON_MASK))
+            return -1;
+
+        writeControl(control | SHOULD_SLEEP_MASK);
+        return 0;
+    }
+
+    inline
+    int resume() {
+        /*
+         * The driver sends Display ON as soon as it is done with the transfer
+         * (burst) at hand, ahead of the rest of the FIFO, so the FIFO is let
+         * drain first for a staged frame to come up whole. Return 0, or -1
+         * when the display is off.
+         */
+        if (!(control & SHOULD_TURN_POWER_ON_MASK))
+            return -1;
+
+        waitForDmaDone();
+        waitForFifoDrained();
+        writeControl(control & ~SHOULD_SLEEP_MASK);
+        return 0;
+    }
+
+    inline
+    int waitForAwake(int waitsMax) {
+        /*
+         * Wait for Display ON of resume() to go out, giving up after waitsMax
+         * calls of the wait function, or status reads when there is none.
+         * Return 0, or -1 when the display is still asleep.
+         */
+        return waitWhile(IS_ASLEEP_MASK, SEND_DONE_IRQ_MASK, waitsMax) ? 0 : -1;
+    }
+
+    inline
+    bool isAsleep() {
+        /* Whether Display OFF of sleep() has gone out, and ON not yet. */
+        u32 reg2 = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET);
+        return reg2 & IS_ASLEEP_MASK;
     }
 
     inline
     void send(Command cmd) {
-        /* Store original value of the control register (reg0). */
-        u32 reg0 =
-            SSD1306_DRIVER_mReadReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET
-            );
+        /* The control register (reg0) is never read back, see control. */
+        u32 reg0 = control;
 
         /* Sending commands makes sense only when the display is powered on. */
         if (reg0 & SHOULD_TURN_POWER_ON_MASK) {
 
+            /* Let whatever is queued in the TX FIFO go out first. */
+            waitForFifoDrained();
+
             /* 8-bit transfer, value in reg1 is NOT data. */
             sendWithWait(
                 (reg0 | IS_DIN_U8_MASK) & (~IS_DIN_DATA_MASK),
                 cmd
             );
-
-            /* Restore the original value of the control register reg0. */
-            SSD1306_DRIVER_mWriteReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET,
-                reg0
-            );
         }
     }
 
     inline
     void send(Command cmd, u8 arg) {
-        /* Store original value of the control register (reg0). */
-        u32 reg0 =
-            SSD1306_DRIVER_mReadReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET
-            );
+        /* The control register (reg0) is never read back, see control. */
+        u32 reg0 = control;
 
         /* Sending commands makes sense only when the display is powered on. */
         if (reg0 & SHOULD_TURN_POWER_ON_MASK) {
 
+            /* Let whatever is queued in the TX FIFO go out first. */
+            waitForFifoDrained();
+
             /* 8-bit transfer, value in reg1 is NOT data. */
             u32 r0 = (reg0 | IS_DIN_U8_MASK) & (~IS_DIN_DATA_MASK);
             sendWithWait(r0, cmd);
 
             /* 8-bit transfer, value in reg1 is NOT data. */
             sendWithWait(r0, arg);
-
-            /* Restore the original value of the control register reg0. */
-            SSD1306_DRIVER_mWriteReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET,
-                reg0
-            );
         }
     }
 
     inline
     void send(Command cmd, u8 arg1, u8 arg2) {
-        /* Store original value of the control register (reg0). */
-        u32 reg0 =
-            SSD1306_DRIVER_mReadReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET
-            );
+        /* The control register (reg0) is never read back, see control. */
+        u32 reg0 = control;
 
         /* Sending commands makes sense only when the display is powered on. */
         if (reg0 & SHOULD_TURN_POWER_ON_MASK) {
 
+            /* Let whatever is queued in the TX FIFO go out first. */
+            waitForFifoDrained();
+
             /* 8-bit transfer, value in reg1 is NOT data. */
             u32 r0 = (reg0 | IS_DIN_U8_MASK) & (~IS_DIN_DATA_MASK);
             sendWithWait(r0, cmd);
@@ -226,28 +491,20 @@ public:
 
             /* 8-bit transfer, value in reg1 is NOT data. */
             sendWithWait(r0, arg2);
-
-            /* Restore the original value of the control register reg0. */
-            SSD1306_DRIVER_mWriteReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET,
-                reg0
-            );
         }
     }
 
     inline
     void send(u32 data[], int nels) {
-        /* Store original value of the control register (reg0). */
-        u32 reg0 =
-            SSD1306_DRIVER_mReadReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET
-            );
+        /* The control register (reg0) is never read back, see control. */
+        u32 reg0 = control;
 
         /* Sending data makes sense only when the display is powered on. */
         if (reg0 & SHOULD_TURN_POWER_ON_MASK) {
 
+            /* Let whatever is queued in the TX FIFO go out first. */
+            waitForFifoDrained();
+
             for (int i = 0; i < nels; ++i) {
 
                 /* 32-bit transfer, value in reg1 is data. */
@@ -256,28 +513,20 @@ public:
                     data[i]
                  );
             }
-
-            /* Restore the original value of the control register reg0. */
-            SSD1306_DRIVER_mWriteReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET,
-                reg0
-            );
         }
     }
 
     inline
     void send(u8 data[], int nels) {
-        /* Store original value of the control register (reg0). */
-        u32 reg0 =
-            SSD1306_DRIVER_mReadReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET
-            );
+        /* The control register (reg0) is never read back, see control. */
+        u32 reg0 = control;
 
         /* Sending data makes sense only when the display is powered on. */
         if (reg0 & SHOULD_TURN_POWER_ON_MASK) {
 
+            /* Let whatever is queued in the TX FIFO go out first. */
+            waitForFifoDrained();
+
             for (int i = 0; i < nels; ++i) {
 
                 /* 8-bit transfer, value in reg1 is data. */
@@ -286,45 +535,869 @@ public:
                     data[i]
                  );
             }
-
-            /* Restore the original value of the control register reg0. */
-            SSD1306_DRIVER_mWriteReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET,
-                reg0
-            );
         }
     }
 
     inline void
     send(u8 din, bool is_din_data = false) {
-        /* Store original value of the control register (reg0). */
-        u32 reg0 =
-            SSD1306_DRIVER_mReadReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET
-            );
+        /* The control register (reg0) is never read back, see control. */
+        u32 reg0 = control;
 
         /* Sending data makes sense only when the display is powered on. */
         if (reg0 & SHOULD_TURN_POWER_ON_MASK) {
 
+            /* Let whatever is queued in the TX FIFO go out first. */
+            waitForFifoDrained();
+
             /* 8-bit transfer. */
             u32 r0 = reg0 | IS_DIN_U8_MASK;
             sendWithWait(
                 is_din_data ? r0 | IS_DIN_DATA_MASK: r0 & ~IS_DIN_DATA_MASK,
                 din
             );
+        }
+    }
+
+    /*
+     * The non-blocking API, it goes through the TX FIFO of the driver.
+     *
+     * The trySend() functions queue what fits in the FIFO and return right
+     * away. They return -1 when the display is powered off (nothing can be
+     * sent then), otherwise the number of queued words. Commands are queued
+     * all-or-nothing.
+     *
+     * The queue() functions block only for as long as there is no space in
+     * the FIFO, the calls do not wait for the words to be shifted out.
+     */
+    inline
+    int trySend(u32 data[], int nels) {
+        return tryQueue(IS_DIN_DATA_MASK, data, nels);
+    }
+
+    inline
+    int trySend(Command cmd) {
+        u32 bytes[] = { cmd };
+        return tryQueue(IS_DIN_U8_MASK, bytes, 1, 1);
+    }
+
+    inline
+    int trySend(Command cmd, u8 arg) {
+        u32 bytes[] = { cmd, arg };
+        return tryQueue(IS_DIN_U8_MASK, bytes, 2, 2);
+    }
+
+    inline
+    int trySend(Command cmd, u8 arg1, u8 arg2) {
+        u32 bytes[] = { cmd, arg1, arg2 };
+        return tryQueue(IS_DIN_U8_MASK, bytes, 3, 3);
+    }
+
+    inline
+    void queue(u32 data[], int nels) {
+        while (nels > 0) {
+            int n = trySend(data, nels);
+            if (n < 0)
+                break;
+            if (n == 0)
+                waitForFifoHalfEmpty();
+            data += n;
+            nels -= n;
+        }
+    }
+
+    inline
+    void queue(Command cmd) {
+        while (trySend(cmd) == 0)
+            waitForFifoHalfEmpty();
+    }
+
+    inline
+    void queue(Command cmd, u8 arg) {
+        while (trySend(cmd, arg) == 0)
+            waitForFifoHalfEmpty();
+    }
+
+    inline
+    void queue(Command cmd, u8 arg1, u8 arg2) {
+        while (trySend(cmd, arg1, arg2) == 0)
+            waitForFifoHalfEmpty();
+    }
+
+    /*
+     * A sequence of commands and data runs to be queued with submit() in one
+     * go. Commands and their arguments are copied into the batch, data runs
+     * are kept by reference and must stay intact until submit() returns.
+     * The add() functions return false when the batch is full.
+     */
+    class Batch {
+
+    public:
+        static const int BYTES_MAX = 32;
+        static const int RUNS_MAX = 16;
+
+        Batch():
+            bytesNb(0),
+            runsNb(0) {
+        }
+
+        inline
+        void clear() {
+            bytesNb = 0;
+            runsNb = 0;
+        }
+
+        inline
+        bool add(Command cmd) {
+            u8 bytes[] = { cmd };
+            return addBytes(bytes, 1);
+        }
+
+        inline
+        bool add(Command cmd, u8 arg) {
+            u8 bytes[] = { cmd, arg };
+            return addBytes(bytes, 2);
+        }
+
+        inline
+        bool add(Command cmd, u8 arg1, u8 arg2) {
+            u8 bytes[] = { cmd, arg1, arg2 };
+            return addBytes(bytes, 3);
+        }
+
+        inline
+        bool add(Command cmd, const u8 args[], int argsNb) {
+            if (bytesNb + 1 + argsNb > BYTES_MAX)
+                return false;
+
+            u8 bytes[] = { cmd };
+            return addBytes(bytes, 1) && addBytes(args, argsNb);
+        }
+
+        inline
+        bool add(const u32 data[], int nels) {
+            if (runsNb == RUNS_MAX)
+                return false;
+
+            Run *run = &runs[runsNb++];
+            run->mode = IS_DIN_DATA_MASK;
+            run->data = data;
+            run->first = 0;
+            run->nels = nels;
+            return true;
+        }
+
+    private:
+        friend class Ssd1306;
+
+        struct Run {
+            u32         mode;
+                /* is_din_u8/is_din_data of the run. */
+
+            const u32   *data;
+                /* The words of a data run, 0 for a run of bytes. */
+
+            int         first;
+                /* Index of the first byte in bytes for a run of bytes. */
+
+            int         nels;
+                /* Number of words/bytes in the run. */
+        };
+
+        inline
+        bool addBytes(const u8 bytes[], int nels) {
+            if (bytesNb + nels > BYTES_MAX)
+                return false;
+
+            /* Consecutive commands make a single run. */
+            Run *run = runsNb > 0 ? &runs[runsNb - 1] : 0;
+            if (!run || run->data) {
+                if (runsNb == RUNS_MAX)
+                    return false;
+                run = &runs[runsNb++];
+                run->mode = IS_DIN_U8_MASK;
+                run->data = 0;
+                run->first = bytesNb;
+                run->nels = 0;
+            }
+
+            for (int i = 0; i < nels; ++i)
+                this->bytes[bytesNb++] = bytes[i];
+            run->nels += nels;
+            return true;
+        }
+
+        u32             bytes[BYTES_MAX];
+            /* Commands and arguments, widened to the FIFO word. */
+
+        int             bytesNb;
+            /* Number of used entries in bytes. */
+
+        Run             runs[RUNS_MAX];
+            /* The runs in the order of adding. */
+
+        int             runsNb;
+            /* Number of used entries in runs. */
+    };
+
+    inline
+    int submit(const Batch &batch) {
+        /*
+         * Queue the whole batch, blocking only for as long as there is no
+         * space in the FIFO. Return 0, or -1 when the display is off.
+         */
+        if (!(control & SHOULD_TURN_POWER_ON_MASK))
+            return -1;
+
+        /* The FIFO is all the DMA's while it is running. */
+        waitForDmaDone();
+
+        for (int i = 0; i < batch.runsNb; ++i) {
+            const typename Batch::Run *run = &batch.runs[i];
+            pushAll(
+                run->mode,
+                run->data ? run->data : &batch.bytes[run->first],
+                run->nels
+            );
+        }
+        return 0;
+    }
+
+    inline
+    int startScroll(const Scroll &scroll) {
+        /*
+         * (Re)start scrolling, whatever scrolling was active is deactivated
+         * first, as the parameters must not change while it runs. Return 0,
+         * or -1 when the display is off or the vertical scrolling is out of
+         * bounds, see Scroll, then nothing is sent.
+         */
+        if (scroll.verticalOffset > 0 &&
+                (scroll.fixedRowsNb + scroll.scrolledRowsNb > MULTIPLEX_ROWS_NB ||
+                 scroll.verticalOffset >= scroll.scrolledRowsNb))
+            return -1;
+
+        Batch batch;
+        batch.add(DeactivateScroll);
 
-            /* Restore the original value of the control register reg0. */
-            SSD1306_DRIVER_mWriteReg(
-                XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET,
-                reg0
+        if (scroll.verticalOffset > 0) {
+            batch.add(VerticalScrollArea, scroll.fixedRowsNb, scroll.scrolledRowsNb);
+
+            const u8 args[] = {
+                0x00,
+                (u8)(scroll.firstPage & 0x07),
+                (u8)scroll.interval,
+                (u8)(scroll.lastPage & 0x07),
+                (u8)(scroll.verticalOffset & 0x3F)
+            };
+            batch.add(
+                scroll.direction == ScrollRight ?
+                    VerticalRightHorizontalScroll : VerticalLeftHorizontalScroll,
+                args,
+                sizeof(args)
+            );
+        }
+        else {
+            const u8 args[] = {
+                0x00,
+                (u8)(scroll.firstPage & 0x07),
+                (u8)scroll.interval,
+                (u8)(scroll.lastPage & 0x07),
+                0x00,
+                0xFF
+            };
+            batch.add(
+                scroll.direction == ScrollRight ?
+                    RightHorizontalScroll : LeftHorizontalScroll,
+                args,
+                sizeof(args)
             );
         }
+        batch.add(ActivateScroll);
+
+        if (submit(batch) < 0)
+            return -1;
+        isScrolling = true;
+        return 0;
+    }
+
+    inline
+    int stopScroll() {
+        /*
+         * Deactivate scrolling. GDDRAM has to be rewritten afterwards, e.g.
+         * through FramePresenter::invalidate(), the datasheet leaves its
+         * contents undefined. Return 0, or -1 when the display is off.
+         */
+        if (!isScrolling)
+            return 0;
+
+        Batch batch;
+        batch.add(DeactivateScroll);
+        if (submit(batch) < 0)
+            return -1;
+        isScrolling = false;
+        return 0;
+    }
+
+    inline
+    bool isScrollActive() const {
+        return isScrolling;
+    }
+
+    /*
+     * Scripts.
+     *
+     * A script is a sequence of commands, data bytes and waits that the IP
+     * runs by itself, out of its script memory: loaded once with loadScript(),
+     * it is queued with runScript(), a single register write however long the
+     * script is, rather than a FIFO entry per byte. A part of a script can be
+     * repeated, with beginLoop() and endLoop(), and a script can go on with
+     * another one with addJump(). The add() functions return false when the
+     * script is full.
+     */
+    class Script {
+
+    public:
+        static const int WORDS_MAX = SCRIPT_WORDS_NB - 1;
+            /* The script memory, less the End that loadScript() appends. */
+
+        static const int TIMES_MAX = 1023;
+        static const int WAIT_MS_MAX = 1023;
+
+        Script():
+            wordsNb(0),
+            loopIdx(-1) {
+        }
+
+        inline
+        void clear() {
+            wordsNb = 0;
+            loopIdx = -1;
+        }
+
+        inline
+        bool add(Command cmd) {
+            u8 bytes[] = { cmd };
+            return addBytes(COMMAND, bytes, 1);
+        }
+
+        inline
+        bool add(Command cmd, u8 arg) {
+            u8 bytes[] = { cmd, arg };
+            return addBytes(COMMAND, bytes, 2);
+        }
+
+        inline
+        bool add(Command cmd, u8 arg1, u8 arg2) {
+            u8 bytes[] = { cmd, arg1, arg2 };
+            return addBytes(COMMAND, bytes, 3);
+        }
+
+        inline
+        bool add(Command cmd, const u8 args[], int argsNb) {
+            if (wordsNb + 1 + argsNb > WORDS_MAX)
+                return false;
+
+            u8 bytes[] = { cmd };
+            return addBytes(COMMAND, bytes, 1) && addBytes(COMMAND, args, argsNb);
+        }
+
+        inline
+        bool addData(const u8 bytes[], int nels) {
+            /* Bytes for GDDRAM, where the addressing mode puts them. */
+            return addBytes(DATA, bytes, nels);
+        }
+
+        inline
+        bool addWait(int ms) {
+            /* Hold the next instruction off for ms milliseconds. */
+            int n = (ms + WAIT_MS_MAX - 1) / WAIT_MS_MAX;
+            if (wordsNb + n > WORDS_MAX)
+                return false;
+
+            for (; ms > 0; ms -= WAIT_MS_MAX)
+                words[wordsNb++] = WAIT | (ms < WAIT_MS_MAX ? ms : WAIT_MS_MAX);
+            return true;
+        }
+
+        inline
+        bool beginLoop(int timesNb) {
+            /*
+             * Run what is added up to endLoop() timesNb times, up to
+             * TIMES_MAX. Loops do not nest, the IP has a single counter.
+             */
+            if (loopIdx >= 0 || timesNb < 1 || timesNb > TIMES_MAX ||
+                    !addWord(SET_LOOP | timesNb))
+                return false;
+
+            loopIdx = wordsNb;
+            return true;
+        }
+
+        inline
+        bool endLoop() {
+            if (loopIdx < 0 || !addWord(LOOP | loopIdx))
+                return false;
+
+            loopIdx = -1;
+            return true;
+        }
+
+        inline
+        bool addJump(u8 address) {
+            /* Go on with the script loaded at address, nothing added after runs. */
+            return addWord(JUMP | address);
+        }
+
+        inline
+        int getWordsNb() const {
+            return wordsNb;
+        }
+
+    private:
+        friend class Ssd1306;
+
+        /* The instructions, see src/ssd1306-driver.v of the IP. */
+        static const u16 COMMAND = 0x0000;
+        static const u16 DATA = 0xA000;
+        static const u16 JUMP = 0xA400;
+        static const u16 SET_LOOP = 0xA800;
+        static const u16 LOOP = 0xAC00;
+        static const u16 WAIT = 0xB000;
+        static const u16 END = 0xBC00;
+        static const u16 OPCODE_MASK = 0xFC00;
+
+        inline
+        bool addBytes(u16 opcode, const u8 bytes[], int nels) {
+            if (wordsNb + nels > WORDS_MAX)
+                return false;
+
+            for (int i = 0; i < nels; ++i)
+                words[wordsNb++] = opcode | bytes[i];
+            return true;
+        }
+
+        inline
+        bool addWord(u16 word) {
+            if (wordsNb == WORDS_MAX)
+                return false;
+
+            words[wordsNb++] = word;
+            return true;
+        }
+
+        inline
+        u16 getWord(int idx, u8 address) const {
+            /* Word idx as loaded at address, loops jump within the script. */
+            u16 word = words[idx];
+            if ((word & OPCODE_MASK) == LOOP)
+                word = LOOP | ((word + address) & 0xFF);
+            return word;
+        }
+
+        u16             words[WORDS_MAX];
+            /* The instructions in the order of adding, loops relative to 0. */
+
+        int             wordsNb;
+            /* Number of used entries in words. */
+
+        int             loopIdx;
+            /* Index of the first word of the loop begun, -1 when none is. */
+    };
+
+    inline
+    int loadScript(u8 address, const Script &script) {
+        /*
+         * Store script in the script memory at address, followed by an End,
+         * for runScript(address). Nothing that is running or queued to run
+         * may be overwritten. Return the address past the End, where the next
+         * script can go, or -1 when the script does not fit, or has a loop
+         * that was not ended.
+         */
+        if (address + script.wordsNb + 1 > SCRIPT_WORDS_NB || script.loopIdx >= 0)
+            return -1;
+
+        for (int i = 0; i < script.wordsNb; ++i) {
+            writeReg(
+                SSD1306_DRIVER_S00_AXI_SLV_REG18_OFFSET,
+                ((u32)(address + i) << SCRIPT_ADDR_SHIFT) | script.getWord(i, address)
+            );
+        }
+        writeReg(
+            SSD1306_DRIVER_S00_AXI_SLV_REG18_OFFSET,
+            ((u32)(address + script.wordsNb) << SCRIPT_ADDR_SHIFT) | Script::END
+        );
+        return address + script.wordsNb + 1;
+    }
+
+    inline
+    int runScript(u8 address) {
+        /*
+         * Queue the script loaded at address, it runs after what is queued
+         * already. Return 0, or -1 when the display is off.
+         */
+        if (!(control & SHOULD_TURN_POWER_ON_MASK))
+            return -1;
+
+        /* The FIFO is all the DMA's while it is running. */
+        waitForDmaDone();
+
+        while (fifoSpace == 0) {
+            fifoSpace =
+                readReg(SSD1306_DRIVER_S00_AXI_SLV_REG5_OFFSET) >> FIFO_SPACE_SHIFT;
+            if (fifoSpace == 0)
+                waitForFifoHalfEmpty();
+        }
+        writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG19_OFFSET, address);
+        --fifoSpace;
+        return 0;
+    }
+
+    inline
+    u32 getMmioReadsNb() const {
+        /* Number of register reads since the driver was constructed. */
+        return mmioReadsNb;
+    }
+
+    inline
+    u32 getMmioWritesNb() const {
+        /* Number of register writes since the driver was constructed. */
+        return mmioWritesNb;
+    }
+
+    inline
+    bool isFifoDrained() {
+        /* Everything that was queued has been shifted out. */
+        u32 reg2 = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET);
+        return !(reg2 & IS_FIFO_DRAINING_MASK);
+    }
+
+    inline
+    void waitForFifoDrained() {
+        waitWhile(IS_FIFO_DRAINING_MASK, FIFO_DRAINED_IRQ_MASK);
+    }
+
+    /*
+     * Have the driver fetch nels words at data from memory by itself and
+     * queue them as data, after whatever is queued already. The call returns
+     * as soon as the transfer is started, data must stay intact until
+     * isDmaBusy() says otherwise. Return nels, or -1 when the display is off.
+     */
+    inline
+    int startDma(const u32 data[], int nels) {
+        /* Sending makes sense only when the display is powered on. */
+        if (!(control & SHOULD_TURN_POWER_ON_MASK))
+            return -1;
+
+        /* Only one transfer at a time. */
+        waitForDmaDone();
+
+        /* The driver reads DDR behind the back of the data cache. */
+        bus.flushForDevice(data, nels * sizeof(u32));
+
+        writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG6_OFFSET, bus.toBusAddress(data));
+        writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG7_OFFSET, nels * sizeof(u32));
+        isDmaPending = true;
+
+        return nels;
+    }
+
+    inline
+    bool isDmaBusy() {
+        u32 reg2 = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET);
+        return reg2 & IS_DMA_BUSY_MASK;
+    }
+
+    inline
+    bool hasDmaFailed() {
+        /* The last transfer hit a bus error, it is cleared by the next one. */
+        u32 reg2 = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET);
+        return reg2 & HAS_DMA_FAILED_MASK;
+    }
+
+    inline
+    void waitForDmaDone() {
+        if (isDmaPending) {
+            waitWhile(IS_DMA_BUSY_MASK, DMA_DONE_IRQ_MASK);
+            isDmaPending = false;
+
+            /* The DMA has used up some of the space we knew about. */
+            fifoSpace = 0;
+        }
+    }
+
+    /*
+     * The SPI link.
+     *
+     * SCLK runs at the AXI clock divided by divider + 1, which can be changed
+     * at any time, even with transfers queued: the driver takes it over
+     * between transfers (bursts when streaming). The panel is specified for
+     * SCLK up to 10MHz, but the wiring of a given board may do better or
+     * worse than that.
+     */
+    inline
+    void setStreaming(bool isOn) {
+        /*
+         * Send what is queued in the FIFO in gapless bursts (see slv_reg0),
+         * it sticks across power cycles.
+         */
+        writeControl(isOn ? control | SHOULD_STREAM_MASK : control & ~SHOULD_STREAM_MASK);
+    }
+
+    inline
+    bool isStreaming() const {
+        return control & SHOULD_STREAM_MASK;
+    }
+
+    inline
+    void setSclkDivider(u8 divider) {
+        /* 0 goes back to SCLK_DIVIDER_DEFAULT. */
+        writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG3_OFFSET, divider);
+    }
+
+    inline
+    u8 getSclkDivider() {
+        /* The divider in use. */
+        u8 divider = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG3_OFFSET) & SCLK_DIVIDER_MASK;
+        if (divider == 0)
+            return SCLK_DIVIDER_DEFAULT;
+        return divider < SCLK_DIVIDER_MIN ? SCLK_DIVIDER_MIN : divider;
+    }
+
+    inline
+    u8 calibrateSclkDivider(CheckFn checkFn, void *context) {
+        /*
+         * Step the divider down from the one in use to SCLK_DIVIDER_MIN and
+         * keep the lowest one, i.e. the fastest SCLK, that every step down
+         * to it has passed with. At every step a checkerboard, inverted from
+         * the previous step's, is written to the whole of GDDRAM and
+         * checkFn(context, divider) tells whether it made it to the panel
+         * intact, e.g. by asking the user. The serial interface cannot be
+         * read back, so the driver itself only makes sure that the words
+         * have been shifted out.
+         *
+         * Return the divider that is left set, or 0 when the display is off.
+         * GDDRAM has to be rewritten afterwards, e.g. through
+         * FramePresenter::invalidate().
+         */
+        if (!(control & SHOULD_TURN_POWER_ON_MASK))
+            return 0;
+
+        u8 passed = getSclkDivider();
+        for (int divider = passed; divider >= SCLK_DIVIDER_MIN; --divider) {
+            setSclkDivider(divider);
+
+            /* Columns of alternating rows, 0x55 and 0xAA in turn. */
+            u32 words[WORDS_PER_PAGE];
+            u32 checkerboard = divider & 1 ? 0xAA55AA55 : 0x55AA55AA;
+            for (int i = 0; i < WORDS_PER_PAGE; ++i)
+                words[i] = checkerboard;
+
+            queue(ColumnAddress, 0, COLUMNS_NB - 1);
+            queue(PageAddress, 0, GDDRAM_PAGES_NB - 1);
+            for (int page = 0; page < GDDRAM_PAGES_NB; ++page)
+                queue(words, WORDS_PER_PAGE);
+            waitForFifoDrained();
+
+            if (!checkFn(context, divider))
+                break;
+            passed = divider;
+        }
+
+        setSclkDivider(passed);
+        return passed;
+    }
+
+    /*
+     * Performance counters.
+     *
+     * The counters of the IP run all the time, a read takes a snapshot of all
+     * of them first, so they agree with each other. With shouldClear they
+     * start over right after, i.e. every read covers the time since the last.
+     */
+    inline
+    void readPerfCounters(PerfCounters *counters, bool shouldClear = false) {
+        writeReg(
+            SSD1306_DRIVER_S00_AXI_SLV_REG10_OFFSET,
+            PERF_SNAPSHOT_MASK | (shouldClear ? PERF_CLEAR_MASK : 0)
+        );
+        counters->wordsNb = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG11_OFFSET);
+        counters->commandBytesNb = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG12_OFFSET);
+        counters->dataBytesNb = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG13_OFFSET);
+        counters->busyCycles = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG14_OFFSET);
+        counters->idleCycles = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG15_OFFSET);
+        counters->romCycles = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG16_OFFSET);
+        counters->longestGapCycles = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG17_OFFSET);
+        counters->overflows = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG10_OFFSET);
+    }
+
+    inline
+    void clearPerfCounters() {
+        writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG10_OFFSET, PERF_CLEAR_MASK);
+    }
+
+    /*
+     * Waiting for the driver.
+     *
+     * By default every wait is a loop reading the status register. Once
+     * a wait function is set, a wait enables the interrupt for the event it
+     * waits for and calls waitFn(context), which is expected to block the
+     * calling task until handleInterrupt() has been called from the ISR of
+     * the irq line (or a timeout, the condition is checked again anyway).
+     * Setting waitFn to 0 goes back to polling.
+     */
+    inline
+    void setWaitFn(WaitFn fn, void *context) {
+        waitFn = fn;
+        waitContext = context;
+    }
+
+    inline
+    u32 handleInterrupt() {
+        /*
+         * Mask the irq, the line is level sensitive and stays high until the
+         * woken up task clears the event. Return the latched events.
+         */
+        writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG8_OFFSET, 0);
+        return readReg(SSD1306_DRIVER_S00_AXI_SLV_REG9_OFFSET);
     }
 
 private:
+    static const int COLUMNS_NB = 128;
+    static const int GDDRAM_PAGES_NB = 8;
+    static const int WORDS_PER_PAGE = COLUMNS_NB / 4;
+    static const int MULTIPLEX_ROWS_NB = 32;
+        /* The rows of the panel, A8h 1Fh of the ROM. */
+
+    /*
+     * Push up to nels words to the FIFO with the din flags set as per mode.
+     * Return the number of pushed words, 0 when fewer than min words would
+     * fit, or -1 when the display is off.
+     */
+    inline
+    int tryQueue(u32 mode, const u32 words[], int nels, int min = 1) {
+        /* Sending makes sense only when the display is powered on. */
+        if (!(control & SHOULD_TURN_POWER_ON_MASK))
+            return -1;
+
+        /* The FIFO is all the DMA's while it is running. */
+        waitForDmaDone();
+
+        return push(mode, words, nels, min);
+    }
+
+    /*
+     * The part of tryQueue() past the checks, for the callers that have done
+     * them already.
+     */
+    inline
+    int push(u32 mode, const u32 words[], int nels, int min = 1) {
+        /*
+         * The FIFO only gets emptier behind our back, so the space that was
+         * read last time is a safe lower bound, read it again only when that
+         * is not enough.
+         */
+        if (fifoSpace < (u32)nels) {
+            fifoSpace =
+                readReg(SSD1306_DRIVER_S00_AXI_SLV_REG5_OFFSET) >> FIFO_SPACE_SHIFT;
+        }
+        if (fifoSpace < (u32)min)
+            return 0;
+        if ((u32)nels > fifoSpace)
+            nels = fifoSpace;
+
+        /* The entries pick up is_din_u8/is_din_data from reg0. */
+        writeControl(
+            (control & ~(SHOULD_SEND_DIN_MASK | IS_DIN_DATA_MASK | IS_DIN_U8_MASK)) |
+            mode
+        );
+
+        for (int i = 0; i < nels; ++i) {
+            writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG4_OFFSET, words[i]);
+        }
+        fifoSpace -= nels;
+
+        return nels;
+    }
+
+    inline
+    void pushAll(u32 mode, const u32 words[], int nels) {
+        while (nels > 0) {
+            int n = push(mode, words, nels);
+            if (n == 0)
+                waitForFifoHalfEmpty();
+            words += n;
+            nels -= n;
+        }
+    }
+
+    inline
+    u32 readReg(u32 offset) {
+        ++mmioReadsNb;
+        return bus.read(offset);
+    }
+
+    inline
+    void writeReg(u32 offset, u32 value) {
+        ++mmioWritesNb;
+        bus.write(offset, value);
+    }
+
+    inline
+    void writeControl(u32 reg0) {
+        /* Write reg0 through the shadow copy, skip writes that change nothing. */
+        if (reg0 != control) {
+            control = reg0;
+            writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET, reg0);
+        }
+    }
+
+    /*
+     * Wait for as long as any of the statusMask bits is set in reg2, irqMask
+     * is the event of those bits going low. Give up after waitsMax waits
+     * (status reads when polling), -1 for no limit. Return whether the bits
+     * went low.
+     */
+    inline
+    bool waitWhile(u32 statusMask, u32 irqMask, int waitsMax = -1) {
+        if (!waitFn) {
+            while (
+                readReg(SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET) & statusMask
+            ) {
+                if (waitsMax == 0)
+                    return false;
+                if (waitsMax > 0)
+                    --waitsMax;
+            }
+            return true;
+        }
+
+        bool isDone = false;
+        while (true) {
+            /* Forget an old edge, then check the level. */
+            writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG9_OFFSET, irqMask);
+            u32 reg2 = readReg(SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET);
+            if (!(reg2 & statusMask)) {
+                isDone = true;
+                break;
+            }
+            if (waitsMax == 0)
+                break;
+            if (waitsMax > 0)
+                --waitsMax;
+
+            /* An edge after the check is latched and fires right away. */
+            writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG8_OFFSET, irqMask);
+            waitFn(waitContext);
+        }
+
+        writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG8_OFFSET, 0);
+        return isDone;
+    }
+
+    inline
+    void waitForFifoHalfEmpty() {
+        waitWhile(IS_FIFO_OVER_HALF_MASK, FIFO_HALF_EMPTY_IRQ_MASK);
+    }
+
     /*
      * Wait in loop for indication that the driver is done with sending.
      */
@@ -332,42 +1405,55 @@ private:
     void sendWithWait(u32 reg0, u32 din) {
 
         /* Populate the register reg1 with value of din. */
-        SSD1306_DRIVER_mWriteReg(
-            XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-            SSD1306_DRIVER_S00_AXI_SLV_REG1_OFFSET,
-            din
-        );
+        writeReg(SSD1306_DRIVER_S00_AXI_SLV_REG1_OFFSET, din);
 
         /* Signal the driver that din is ready to send. */
-        SSD1306_DRIVER_mWriteReg(
-            XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-            SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET,
-            reg0 | SHOULD_SEND_DIN_MASK
-        );
+        writeControl(reg0 | SHOULD_SEND_DIN_MASK);
 
         waitForSendDone(reg0);
     }
 
     inline
     void waitForSendDone(u32 reg0) {
-        u32 reg2;
-        bool read_flag = false;
-        do {
-            reg2 =
-                SSD1306_DRIVER_mReadReg(
-                    XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                    SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET
-                );
-            /* Clear the should_send_din flag after the first check of the is_busy status. */
-            if (!read_flag) {
-                reg0 &= ~SHOULD_SEND_DIN_MASK;
-                SSD1306_DRIVER_mWriteReg(
-                    XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR,
-                    SSD1306_DRIVER_S00_AXI_SLV_REG0_OFFSET,
-                    reg0
-                );
-                read_flag = true;
-            }
-        } while (reg2 & IS_BUSY_MASK);
+        /*
+         * Clear the should_send_din flag after the first check of the is_busy
+         * status, by then the driver has picked din up.
+         */
+        readReg(SSD1306_DRIVER_S00_AXI_SLV_REG2_OFFSET);
+        writeControl(reg0 & ~SHOULD_SEND_DIN_MASK);
+
+        waitWhile(IS_BUSY_MASK, SEND_DONE_IRQ_MASK);
     }
+
+    Bus             bus;
+        /* Where the registers of the IP instance are. */
+
+    u32             control;
+        /*
+         * Shadow copy of the control register (reg0). The driver is its only
+         * writer, so it is never read back over the bus.
+         */
+
+    u32             fifoSpace;
+        /* Lower bound of free entries in the TX FIFO. */
+
+    bool            isDmaPending;
+        /* A DMA transfer was started and has not been seen finished yet. */
+
+    bool            isScrolling;
+        /* Scrolling was activated and has not been deactivated since. */
+
+    WaitFn          waitFn;
+        /* Blocks the caller until the driver interrupts, 0 for polling. */
+
+    void            *waitContext;
+        /* The argument of waitFn. */
+
+    u32             mmioReadsNb;
+        /* Number of register reads so far. */
+
+    u32             mmioWritesNb;
+        /* Number of register writes so far. */
 };
+
+#endif // SSD1306_HPP
@@ -1,56 +1,345 @@
 #include "FreeRTOS.h"
-#include "timers.h"
 #include "task.h"
 #include "queue.h"
+#include "semphr.h"
+#include "timers.h"
+#include "event_groups.h"
+#include <string.h>
 #include "xil_printf.h"
 #include "xstatus.h"
 #include "sleep.h"
+#include "MmioBus.hpp"
 #include "Ssd1306.hpp"
+#include "FramePresenter.hpp"
+#include "FrameDecoder.hpp"
+#include "FrameStream.hpp"
+#include "MemoryStorage.hpp"
+#include "FrameRing.hpp"
 
 #define EOL     "\r\n"
 #define ED      "\x1b[2J"
 #define CUP     "\x1b[H"
 #define NELS(a) (sizeof(a) / sizeof(a[0]))
 
-struct Frames {
-    u32 buffer[1*128];
-    int delay;
+/*
+ * Whether the tasks sleep on the irq of the driver while waiting for the
+ * display (1), or keep polling its status register (0).
+ */
+#define SHOULD_USE_DISPLAY_IRQ  1
+
+/*
+ * The longest a task sleeps on the irq before it checks the status register
+ * anyway, just in case an edge gets lost.
+ */
+#define DISPLAY_IRQ_TIMEOUT     pdMS_TO_TICKS(100)
+
+/*
+ * How long a panel that is woken up gets to send Display ON, in waits on its
+ * irq, or in status reads while it is polled.
+ */
+#define WAKE_WAITS_MAX          (SHOULD_USE_DISPLAY_IRQ ? 4 : 1000000)
+
+/*
+ * Whether frames are written to the off-screen half of GDDRAM and flipped on
+ * screen (1), or written straight to the visible rows (0).
+ */
+#define SHOULD_DOUBLE_BUFFER    1
+
+/*
+ * Whether the SPI clock is tuned for the board before the menu shows up (1),
+ * or left at the divider the IP was synthesised with (0).
+ */
+#define SHOULD_CALIBRATE_SCLK   0
+
+/*
+ * Whether the queued words go out over SPI in gapless bursts (1), or as
+ * a transfer per word (0).
+ */
+#define SHOULD_STREAM_SPI       1
+
+/*
+ * Whether the panels fade out before they go to sleep and in after they wake
+ * up (1), by scripts that the IPs run by themselves, or just go blank and lit
+ * again (0).
+ */
+#define SHOULD_FADE_ON_SLEEP    1
+
+/* The contrast of the power on sequence, which the fades go down from and up to. */
+#define CONTRAST                0x0F
+
+/* How long a contrast level lasts in a fade [ms]. */
+#define FADE_STEP_MS            8
+
+/* Where the fade scripts are in the script memory of the IPs. */
+#define FADE_OUT_SCRIPT         0
+#define FADE_IN_SCRIPT          64
+
+/*
+ * The most panels, i.e. ssd1306_driver instances, that the application drives,
+ * two event group bits each, see Application::panelEvents.
+ */
+#define PANELS_MAX              8
+
+/* The event group bit a panel sets once its frame is staged... */
+#define PANEL_STAGED_BIT(i)     (1u << (i))
+
+/* ... and the one it sets once its frame is on screen. */
+#define PANEL_DONE_BIT(i)       (1u << (PANELS_MAX + (i)))
+
+/* The stack of a render task, FramePresenter::stage() keeps its windows there. */
+#define RENDER_TASK_STACK_SIZE  (configMINIMAL_STACK_SIZE * 4)
+
+/*
+ * What happens when the frames run late, i.e. the next one is due already by
+ * the time the panels are done with the last one:
+ *  - OVERRUN_CATCH_UP, the late ones follow back to back until the schedule
+ *    is met again,
+ *  - OVERRUN_DROP, the ones that would be replaced before they are seen are
+ *    decoded but not shown,
+ *  - OVERRUN_SLIP, the schedule starts over from the late one, which delays
+ *    the rest of the animation.
+ */
+#define OVERRUN_CATCH_UP        0
+#define OVERRUN_DROP            1
+#define OVERRUN_SLIP            2
+#define FRAME_OVERRUN_POLICY    OVERRUN_DROP
+
+/*
+ * Whether the animations are read from the QSPI flash (1), where their
+ * containers have been programmed ANIMATION_SLOT_SIZE apart from
+ * ANIMATIONS_FLASH_OFFSET on, see README.md, or built into the image (0).
+ */
+#define SHOULD_READ_ANIMATIONS_FROM_FLASH 0
+
+/* Past the boot image. */
+#define ANIMATIONS_FLASH_OFFSET 0x800000
+
+/* The room for the container of an animation. */
+#define ANIMATION_SLOT_SIZE     0x10000
+
+/*
+ * Whether the generator drops the oldest frame it has queued when the ring is
+ * full (1), or waits for the panels to catch up (0).
+ */
+#define SHOULD_OVERWRITE_OLDEST 0
+
+/* How long a generated frame stays. */
+#define GENERATED_FRAME_DELAY_MS 40
+
+/* The clock of the AXI port of the driver (FCLK_CLK0), SCLK is divided from it. */
+#define DISPLAY_AXI_CLK_HZ      100000000
+
+/*
+ * Whether the frames shown are traced, what it took to send them and how late
+ * they were, for the menu to print (1), or nothing of it gets built (0).
+ */
+#define SHOULD_TRACE_FRAMES     1
+
+#if SHOULD_TRACE_FRAMES
+#include "xtime_l.h"
+#include "FrameTrace.hpp"
+
+/* The global timer ticks at half the CPU clock. */
+#define TICKS_PER_US            (COUNTS_PER_SECOND / 1000000)
+#endif
+
+typedef Ssd1306<RuntimeMmioBus> Display;
+typedef FramePresenter<Display> Presenter;
+typedef FrameStream<MemoryStorage> Frames;
+typedef FrameRing<4> Ring;
+
+/*
+ * The ssd1306_driver instances of the hardware design, a panel each. They all
+ * show the same animation and flip to every frame of it together.
+ */
+struct PanelConfig {
+    UINTPTR         baseAddress;
+    u32             irqId;
+};
+
+static const PanelConfig panelConfigs[] = {
+    { XPAR_SSD1306_DRIVER_0_S00_AXI_BASEADDR, XPAR_FABRIC_SSD1306_DRIVER_0_IRQ_INTR },
+#ifdef XPAR_SSD1306_DRIVER_1_S00_AXI_BASEADDR
+    { XPAR_SSD1306_DRIVER_1_S00_AXI_BASEADDR, XPAR_FABRIC_SSD1306_DRIVER_1_IRQ_INTR },
+#endif
+#ifdef XPAR_SSD1306_DRIVER_2_S00_AXI_BASEADDR
+    { XPAR_SSD1306_DRIVER_2_S00_AXI_BASEADDR, XPAR_FABRIC_SSD1306_DRIVER_2_IRQ_INTR },
+#endif
+#ifdef XPAR_SSD1306_DRIVER_3_S00_AXI_BASEADDR
+    { XPAR_SSD1306_DRIVER_3_S00_AXI_BASEADDR, XPAR_FABRIC_SSD1306_DRIVER_3_IRQ_INTR },
+#endif
 };
 
-static Frames frames1[] =
-#include "380r-u32.inc"
+/*
+ * The animations are kept in containers, see utils/framepack, their frames are
+ * fetched and decoded one at a time right before they are presented.
+ */
+#if SHOULD_READ_ANIMATIONS_FROM_FLASH
+static MemoryStorage
+getFlashSlot(int slot)
+{
+    /* The container programmed into slot of the flash, read in linear mode. */
+    return MemoryStorage(
+        (const void *)(UINTPTR)(XPAR_PS7_QSPI_LINEAR_0_S_AXI_BASEADDR +
+            ANIMATIONS_FLASH_OFFSET + slot * ANIMATION_SLOT_SIZE),
+        ANIMATION_SLOT_SIZE
+    );
+}
+#else
+static const u8 container1[] =
+#include "380r-anim.inc"
 
-static Frames frames2[] =
-#include "aha2-u32.inc"
+static const u8 container2[] =
+#include "aha2-anim.inc"
 
-static Frames frames3[] =
-#include "cascade-u32.inc"
+static const u8 container3[] =
+#include "cascade-anim.inc"
 
-static Frames frames4[] =
-#include "eyes-u32.inc"
+static const u8 container4[] =
+#include "eyes-anim.inc"
+#endif
 
+/*
+ * An animation, or scrolling content when scroll is set: then only its first
+ * frame is pushed and the controller keeps moving it with hardware scrolling,
+ * so the motion costs nothing on the bus. Or content rendered as it plays,
+ * when isGenerated is set, by the Generate task into Application::ring.
+ */
 struct Animation {
-    Frames *frames;
-    size_t  framesNb;
+
+    Animation(const MemoryStorage &storage, const Display::Scroll *sp = 0,
+            bool ig = false):
+        decoder(storage),
+        scroll(sp),
+        isGenerated(ig) {
+    }
+
+    Frames          decoder;
+        /* The packed frames, fetched as they are decoded. */
+
+    const Display::Scroll *scroll;
+        /* How the content scrolls, 0 for an animation. */
+
+    bool            isGenerated;
+        /* Whether the frames come from Application::ring instead. */
+};
+
+static const Display::Scroll marquee = {
+    Display::ScrollLeft,
+    0,                  /* The first page... */
+    3,                  /* ... to the last one. */
+    Display::Frames2,
+    0,                  /* No vertical scrolling. */
+    0,
+    0
 };
 
 typedef size_t AnimationIdx;
 
+struct Application;
+
+/*
+ * A panel, the driver of its ssd1306_driver instance and the task that renders
+ * the frames on it.
+ */
+struct Panel {
+
+    Panel():
+        application(0),
+        index(0),
+        irqId(0),
+        presenter(&display),
+        renderTask(0),
+        irqSemaphore(0) {
+#if SHOULD_TRACE_FRAMES
+        sendUs = 0;
+        waitsNb = 0;
+        bytesNb = 0;
+#endif
+    }
+
+    Application     *application;
+        /* The application the panel belongs to. */
+
+    int             index;
+        /* Index of the panel in Application::panels. */
+
+    u32             irqId;
+        /* The interrupt of the ssd1306_driver instance. */
+
+    Display         display;
+        /* The Ssd1306 driver of the ssd1306_driver instance. */
+
+    Presenter       presenter;
+        /* Pushes to the display only what differs from the previous frame. */
+
+    TaskHandle_t    renderTask;
+        /* Handle of the task rendering the frames on the panel. */
+
+    SemaphoreHandle_t irqSemaphore;
+        /* Given by the ISR of the display driver, taken by a waiting task. */
+
+#if SHOULD_TRACE_FRAMES
+    u32             sendUs;
+        /* The time it took to get the last frame on screen. */
+
+    u32             waitsNb;
+        /*
+         * Number of waits for the IRQ of the last frame, counted by
+         * waitForDisplayIrq(). It stays 0 while the driver polls.
+         */
+
+    size_t          bytesNb;
+        /* Number of SPI bytes of the last frame. */
+#endif
+
+private:
+    /* No copying, presenter points at display. */
+    Panel(const Panel &);
+    Panel &operator=(const Panel &);
+};
+
 /*
  * The structure holding application wide objects.
  */
 struct Application {
 
-    Application(Animation ans[], size_t anb, Ssd1306 *dp):
+    Application(Animation ans[], size_t anb, Panel pns[], size_t pnb):
         queue(0),
         showMenuTask(0),
         playAnimationTask(0),
-        animationTimer(0),
+        generateTask(0),
+        panelEvents(0),
+        panelsMutex(0),
         animations(ans),
         animationsNb(anb),
         animationIdx(-1),
-        frameIdx(-1),
-        display(dp) {
+        frame(decodedFrame),
+        frameScroll(0),
+        ring(0),
+        takenSlot(0),
+        shownFramesNb(0),
+        droppedFramesNb(0),
+        panels(pns),
+        panelsNb(pnb) {
+        memset(decodedFrame, 0, sizeof(decodedFrame));
+#if SHOULD_TRACE_FRAMES
+        frameStartTime = 0;
+        frameLateUs = 0;
+        frameDueTime = 0;
+#endif
+    }
+
+    inline
+    EventBits_t getStagedBits() const {
+        /* The event group bits of all the panels having staged their frames. */
+        return (1u << panelsNb) - 1;
+    }
+
+    inline
+    EventBits_t getDoneBits() const {
+        /* The event group bits of all the panels having shown their frames. */
+        return getStagedBits() << PANELS_MAX;
     }
 
     QueueHandle_t   queue;
@@ -62,9 +351,17 @@ struct Application {
     TaskHandle_t    playAnimationTask;
         /* Handle of the PlayAnimation task. */
 
-    TimerHandle_t   animationTimer;
-        /* When this timer expires the next frame from the currently selected
-         * animation is displayed. */
+    TaskHandle_t    generateTask;
+        /* Handle of the Generate task. */
+
+    EventGroupHandle_t panelEvents;
+        /* The PANEL_STAGED_BIT()s that the render tasks sync on before they
+         * flip, and the PANEL_DONE_BIT()s that the PlayAnimation task waits
+         * for before it hands them the next frame. */
+
+    SemaphoreHandle_t panelsMutex;
+        /* Held by the PlayAnimation task while it hands a frame over, and by
+         * the ShowMenu task while it talks to the panels, see lockPanels(). */
 
     Animation       *animations;
         /* Animations that the user can select from. */
@@ -75,12 +372,51 @@ struct Application {
     AnimationIdx    animationIdx;
         /* Index of an animation that is currently selected for being played. */
 
-    size_t          frameIdx;
-        /* Index of a frame in the current animation that the timer function
-         * shows on the display. */
+    u32             decodedFrame[FrameDecoder::WORDS_NB];
+        /* The frame of the current animation decoded last, the next one is
+         * decoded over it. */
+
+    const u32       *frame;
+        /* The frame that the PlayAnimation task has handed to the render
+         * tasks last, decodedFrame or the frame of takenSlot, it stays put
+         * until they are all done with it. */
 
-    Ssd1306         *display;
-        /* The Ssd1306 driver we are going to use to display animations/frames. */
+    const Display::Scroll *frameScroll;
+        /* How frame scrolls once it is shown, 0 when it does not. */
+
+    Ring            *ring;
+        /* The generated frames, from the Generate task to the PlayAnimation
+         * task. */
+
+    const Ring::Slot *takenSlot;
+        /* The slot of the ring that frame is in, 0 when it is not. */
+
+    size_t          shownFramesNb;
+        /* Number of frames shown so far. */
+
+    size_t          droppedFramesNb;
+        /* Number of frames decoded but not shown, being late, so far. */
+
+    Panel           *panels;
+        /* The panels showing the animations. */
+
+    size_t          panelsNb;
+        /* Number of panels. */
+
+#if SHOULD_TRACE_FRAMES
+    FrameTrace      trace;
+        /* The frames shown last, written by the PlayAnimation task, read by
+         * the menu. */
+
+    XTime           frameStartTime;
+        /* When frame was handed to the render tasks, 0 when it was not. */
+
+    u32             frameLateUs;
+        /* How late that was. */
+
+    XTime           frameDueTime;
+        /* When the frame handed to the render tasks next is due. */
+#endif
 
 private:
     /* No default construction. */
@@ -88,51 +424,621 @@ private:
 };
 
 static void
-showFrame(TimerHandle_t xTimer)
+handleDisplayIrq(void *context)
+{
+    Panel *panel = (Panel *)context;
+    BaseType_t hasWokenTask = pdFALSE;
+
+    panel->display.handleInterrupt();
+    xSemaphoreGiveFromISR(panel->irqSemaphore, &hasWokenTask);
+    portYIELD_FROM_ISR(hasWokenTask);
+}
+
+static void
+waitForDisplayIrq(void *context)
+{
+    Panel *panel = (Panel *)context;
+
+    /*
+     * The timer service task runs the callbacks of all the software timers
+     * and must not block, the driver polls the status again from there.
+     */
+    if (xTaskGetCurrentTaskHandle() == xTimerGetTimerDaemonTaskHandle())
+        return;
+
+#if SHOULD_TRACE_FRAMES
+    ++panel->waitsNb;
+#endif
+    xSemaphoreTake(panel->irqSemaphore, DISPLAY_IRQ_TIMEOUT);
+}
+
+static void
+setupDisplayIrq(Panel *panel)
+{
+    /*
+     * The handlers can be installed only once the scheduler has set up the
+     * interrupt controller, i.e. from a task. Until then the driver polls.
+     */
+    panel->irqSemaphore = xSemaphoreCreateBinary();
+    configASSERT(panel->irqSemaphore);
+
+    BaseType_t rc = xPortInstallInterruptHandler(
+        panel->irqId,
+        handleDisplayIrq,
+        panel
+    );
+    configASSERT(rc == pdPASS);
+    vPortEnableInterrupt(panel->irqId);
+
+    panel->display.setWaitFn(waitForDisplayIrq, panel);
+}
+
+static void
+lockPanels(Application *application)
 {
-    Application *application = (Application *)pvTimerGetTimerID(xTimer);
-    Ssd1306 *display = application->display;
+    /*
+     * Keep the render tasks off the panels for the caller to talk to them:
+     * no frame is handed over until unlockPanels(), and the last one is done
+     * with, so the drivers and their irqSemaphores are the caller's alone.
+     */
+    xSemaphoreTake(application->panelsMutex, portMAX_DELAY);
+    xEventGroupWaitBits(
+        application->panelEvents,
+        application->getDoneBits(),
+        pdFALSE,
+        pdTRUE,
+        portMAX_DELAY
+    );
+}
+
+static void
+unlockPanels(Application *application)
+{
+    xSemaphoreGive(application->panelsMutex);
+}
+
+static void
+sendToPanels(Application *application, Display::Command command)
+{
+    for (size_t i = 0; i < application->panelsNb; ++i)
+        application->panels[i].display.send(command);
+}
+
+static void
+printIdleShare()
+{
+#if (configGENERATE_RUN_TIME_STATS == 1) && (configUSE_TRACE_FACILITY == 1)
+    /*
+     * The share of the run time that the idle task got since the last call,
+     * the CPU time the display leaves to everything else.
+     */
+    static uint32_t lastIdleTime = 0;
+    static uint32_t lastTotalTime = 0;
+
+    /*
+     * ShowMenu, PlayAnimation, Generate, IDLE and Tmr Svc, and a Render task
+     * per panel, or uxTaskGetSystemState() reports none. Too much for the
+     * stack of the ShowMenu task, the only caller.
+     */
+    static TaskStatus_t statuses[PANELS_MAX + 5];
+    uint32_t totalTime;
+
+    UBaseType_t statusesNb =
+        uxTaskGetSystemState(statuses, NELS(statuses), &totalTime);
+    for (UBaseType_t i = 0; i < statusesNb; ++i) {
+        if (strcmp(statuses[i].pcTaskName, "IDLE") == 0) {
+            uint32_t idleTime = statuses[i].ulRunTimeCounter;
+            uint32_t elapsedTime = totalTime - lastTotalTime;
+            if (elapsedTime > 0) {
+                xil_printf(
+                    "Idle: %d%%" EOL,
+                    (int)((u64)(idleTime - lastIdleTime) * 100 / elapsedTime)
+                );
+            }
+            lastIdleTime = idleTime;
+            lastTotalTime = totalTime;
+            break;
+        }
+    }
+#endif
+}
+
+static void
+printMmioPerFrame(Panel *panel)
+{
+    /* The register reads and writes per frame shown since the last call. */
+    static u32 lastReadsNb[PANELS_MAX];
+    static u32 lastWritesNb[PANELS_MAX];
+    static size_t lastFramesNb[PANELS_MAX];
+
+    Application *application = panel->application;
+    int i = panel->index;
+    u32 readsNb = panel->display.getMmioReadsNb();
+    u32 writesNb = panel->display.getMmioWritesNb();
+    size_t framesNb = application->shownFramesNb - lastFramesNb[i];
+    if (framesNb > 0) {
+        xil_printf(
+            "Panel %d MMIO per frame: %d reads, %d writes" EOL,
+            i,
+            (int)((readsNb - lastReadsNb[i]) / framesNb),
+            (int)((writesNb - lastWritesNb[i]) / framesNb)
+        );
+    }
+    lastReadsNb[i] = readsNb;
+    lastWritesNb[i] = writesNb;
+    lastFramesNb[i] = application->shownFramesNb;
+}
+
+static void
+printPerfCounters(Panel *panel)
+{
+    /* What the IP did since the last call, per frame shown since then. */
+    static size_t lastFramesNb[PANELS_MAX];
+
+    Application *application = panel->application;
+    int i = panel->index;
+    Display::PerfCounters counters;
+    panel->display.readPerfCounters(&counters, true);
+    size_t framesNb = application->shownFramesNb - lastFramesNb[i];
+    lastFramesNb[i] = application->shownFramesNb;
+
+    u64 poweredCycles = (u64)counters.busyCycles + counters.idleCycles;
+    if (framesNb == 0 || poweredCycles == 0)
+        return;
+
+    /* The counters saturate if the menu is not redrawn for long enough. */
+    xil_printf("Panel %d SPI: busy ", i);
+    if (counters.overflows & (PERF_BUSY_OVERFLOW_MASK | PERF_IDLE_OVERFLOW_MASK))
+        print("overflowed");
+    else
+        xil_printf("%d%%", (int)((u64)counters.busyCycles * 100 / poweredCycles));
+    print(", longest gap ");
+    if (counters.overflows & PERF_GAP_OVERFLOW_MASK)
+        print("overflowed");
+    else
+        xil_printf("%d cycles", (int)counters.longestGapCycles);
+    print(", per frame ");
+    if (counters.overflows & (PERF_WORDS_OVERFLOW_MASK |
+            PERF_COMMAND_BYTES_OVERFLOW_MASK | PERF_DATA_BYTES_OVERFLOW_MASK)) {
+        print("overflowed" EOL);
+        return;
+    }
+    xil_printf(
+        "%d words, %d command and %d data bytes" EOL,
+        (int)(counters.wordsNb / framesNb),
+        (int)(counters.commandBytesNb / framesNb),
+        (int)(counters.dataBytesNb / framesNb)
+    );
+}
+
+static bool
+checkSclkPattern(void *context, u8 divider)
+{
+    Panel *panel = (Panel *)context;
+
+    xil_printf(
+        "SCLK at %d kHz, is panel %d a clean checkerboard? (y/n)" EOL,
+        (int)(DISPLAY_AXI_CLK_HZ / 1000 / (divider + 1)),
+        panel->index
+    );
+    return inbyte() == 'y';
+}
+
+static void
+calibrateSclk(Panel *panel)
+{
+    Display *display = &panel->display;
+
+    /* The pattern has to be seen, not the entirely lit display. */
+    display->send(Display::EntireDisplayResume);
+    u8 divider = display->calibrateSclkDivider(checkSclkPattern, panel);
+    xil_printf("Panel %d SCLK divider: %d" EOL, panel->index, (int)divider);
+    panel->presenter.invalidate();
+    display->send(Display::EntireDisplayOn);
+}
+
+static void
+loadFadeScripts(Display *display)
+{
+    /* The contrast stepped down to 0, and back up, a level at a time. */
+    Display::Script script;
+    for (int level = CONTRAST; level >= 0; --level) {
+        script.add(Display::ContrastControl, (u8)level);
+        script.addWait(FADE_STEP_MS);
+    }
+    int end = display->loadScript(FADE_OUT_SCRIPT, script);
+    configASSERT(end > 0 && end <= FADE_IN_SCRIPT);
+
+    script.clear();
+    for (int level = 0; level <= CONTRAST; ++level) {
+        script.add(Display::ContrastControl, (u8)level);
+        script.addWait(FADE_STEP_MS);
+    }
+    end = display->loadScript(FADE_IN_SCRIPT, script);
+    configASSERT(end > 0);
+}
+
+static void
+toggleSleep(Application *application)
+{
+    /*
+     * Put the panels to sleep, or wake them up. They are powered on from cold
+     * only once, at boot, sleeping just blanks them. The frames keep coming
+     * meanwhile, so a panel wakes up with the current one, a single command
+     * away. The render tasks are kept off the panels in the meantime.
+     */
+    lockPanels(application);
+    for (size_t i = 0; i < application->panelsNb; ++i) {
+        Display *display = &application->panels[i].display;
+        if (!display->isAsleep()) {
+            if (SHOULD_FADE_ON_SLEEP) {
+                /* Sleeping goes ahead of what is queued, the fade must be out. */
+                display->runScript(FADE_OUT_SCRIPT);
+                display->waitForFifoDrained();
+            }
+            display->sleep();
+            xil_printf("Panel %d is asleep." EOL, (int)i);
+            continue;
+        }
+
+#if SHOULD_TRACE_FRAMES
+        XTime start;
+        XTime_GetTime(&start);
+#endif
+        display->resume();
+        if (display->waitForAwake(WAKE_WAITS_MAX) < 0) {
+            xil_printf("Panel %d would not wake up." EOL, (int)i);
+            continue;
+        }
+#if SHOULD_TRACE_FRAMES
+        XTime end;
+        XTime_GetTime(&end);
+        xil_printf("Panel %d woke up in %d us." EOL,
+            (int)i, (int)((end - start) / TICKS_PER_US));
+#else
+        xil_printf("Panel %d woke up." EOL, (int)i);
+#endif
+        if (SHOULD_FADE_ON_SLEEP)
+            display->runScript(FADE_IN_SCRIPT);
+    }
+    unlockPanels(application);
+}
+
+#if SHOULD_TRACE_FRAMES
+static void
+traceFrame(Application *application, XTime startTime)
+{
+    /*
+     * Record the frame that the panels are done with, if any: the time of the
+     * slowest one, the waits and bytes of all of them. The next one starts at
+     * startTime.
+     */
+    if (application->frameStartTime != 0) {
+        FrameTrace::Record record;
+        record.sendUs = 0;
+        record.lateUs = application->frameLateUs;
+        record.waitsNb = 0;
+        record.bytesNb = 0;
+        for (size_t i = 0; i < application->panelsNb; ++i) {
+            Panel *panel = &application->panels[i];
+            if (panel->sendUs > record.sendUs)
+                record.sendUs = panel->sendUs;
+            record.waitsNb += panel->waitsNb;
+            record.bytesNb += panel->bytesNb;
+        }
+        application->trace.add(record);
+    }
+
+    application->frameStartTime = startTime;
+    application->frameLateUs =
+        application->frameDueTime != 0 && startTime > application->frameDueTime ?
+        (u32)((startTime - application->frameDueTime) / TICKS_PER_US) : 0;
+}
+
+static void
+printFrameTraceField(const char *name, const FrameTrace::Record records[],
+    u32 recordsNb, FrameTrace::Field field)
+{
+    static u32 values[FrameTrace::RECORDS_NB];
+    FrameTrace::Summary summary;
+    FrameTrace::summarize(records, recordsNb, field, values, &summary);
+
+    xil_printf(
+        "%s: min %d, p50 %d, p90 %d, p99 %d, max %d" EOL,
+        name,
+        (int)summary.min,
+        (int)summary.p50,
+        (int)summary.p90,
+        (int)summary.p99,
+        (int)summary.max
+    );
+
+    /* A bar of up to 40 stars per non-empty bucket. */
+    for (int b = 0; b < FrameTrace::BUCKETS_NB; ++b) {
+        u32 count = summary.histogram[b];
+        if (count == 0)
+            continue;
+
+        if (b == FrameTrace::BUCKETS_NB - 1)
+            xil_printf("  >=%6d %4d ", (int)FrameTrace::getBucketLimit(b - 1), (int)count);
+        else
+            xil_printf("  < %6d %4d ", (int)FrameTrace::getBucketLimit(b), (int)count);
+        for (u32 i = 0; i < (count * 40 + recordsNb - 1) / recordsNb; ++i)
+            outbyte('*');
+        print(EOL);
+    }
+}
+
+static void
+printFrameTrace(Application *application)
+{
+    static FrameTrace::Record records[FrameTrace::RECORDS_NB];
+    u32 recordsNb = application->trace.copy(records, NELS(records));
+
+    print(ED CUP);
+    xil_printf(
+        "The last %d frames of %d, %d dropped:" EOL,
+        (int)recordsNb,
+        (int)application->trace.getAddedNb(),
+        (int)application->droppedFramesNb
+    );
+    if (recordsNb == 0)
+        return;
+
+    printFrameTraceField("Send [us]", records, recordsNb, FrameTrace::SendUs);
+    printFrameTraceField("Late [us]", records, recordsNb, FrameTrace::LateUs);
+    printFrameTraceField("Waits", records, recordsNb, FrameTrace::WaitsNb);
+    printFrameTraceField("Bytes", records, recordsNb, FrameTrace::BytesNb);
+}
+#endif
+
+static void
+renderFn(void *pvParameters)
+{
+    Panel *panel = (Panel *)pvParameters;
+    Application *application = panel->application;
+    Display *display = &panel->display;
+    Presenter *presenter = &panel->presenter;
+
+    if (SHOULD_USE_DISPLAY_IRQ)
+        setupDisplayIrq(panel);
+
+    while (true) {
+        /* Wait for the PlayAnimation task to hand over the next frame. */
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+#if SHOULD_TRACE_FRAMES
+        panel->waitsNb = 0;
+#endif
+
+        /* GDDRAM is undefined after scrolling, it is pushed again in full. */
+        if (display->isScrollActive()) {
+            display->stopScroll();
+            presenter->invalidate();
+        }
+
+        presenter->stage(application->frame);
+        display->waitForFifoDrained();
+
+        /*
+         * Flip once all the panels have their frames in GDDRAM, so they all
+         * change on the same tick. Without double buffering the frames go
+         * straight to the visible rows and the panels are only about in step.
+         */
+        xEventGroupSync(
+            application->panelEvents,
+            PANEL_STAGED_BIT(panel->index),
+            application->getStagedBits(),
+            portMAX_DELAY
+        );
+        presenter->flip();
+
+        if (application->frameScroll) {
+            Display::Scroll scroll = *application->frameScroll;
+            scroll.firstPage += presenter->getFirstVisiblePage();
+            scroll.lastPage += presenter->getFirstVisiblePage();
+            display->startScroll(scroll);
+        }
+
+#if SHOULD_TRACE_FRAMES
+        XTime now;
+        XTime_GetTime(&now);
+        panel->sendUs = (u32)((now - application->frameStartTime) / TICKS_PER_US);
+        panel->bytesNb = presenter->getBytesNb();
+#endif
+
+        xEventGroupSetBits(application->panelEvents, PANEL_DONE_BIT(panel->index));
+    }
+}
+
+static inline int
+bounce(int t, int max)
+{
+    /* t going from 0 to max and back, over and over. */
+    t %= 2 * max;
+    return t <= max ? t : 2 * max - t;
+}
+
+static void
+drawRipples(u32 frame[FrameDecoder::WORDS_NB], u32 t)
+{
+    /*
+     * Rings spreading out of a centre that bounces off the edges, the
+     * distance being the octagonal approximation max + min / 2, rows
+     * counted twice for the pixels being about square.
+     */
+    int cx = bounce(t * 3, 127);
+    int cy = bounce(t, 31);
+
+    memset(frame, 0, FrameDecoder::WORDS_NB * sizeof(u32));
+    for (int y = 0; y < 32; ++y) {
+        for (int x = 0; x < 128; ++x) {
+            int dx = x > cx ? x - cx : cx - x;
+            int dy = 2 * (y > cy ? y - cy : cy - y);
+            u32 distance = dx > dy ? dx + dy / 2 : dy + dx / 2;
+            if (((distance - t) >> 2) & 1)
+                frame[(y / 8) * 32 + x / 4] |= 1u << ((3 - x % 4) * 8 + y % 8);
+        }
+    }
+}
+
+static void
+generateFn(void *pvParameters)
+{
+    /*
+     * The producer of the ring, it renders while the generated content is
+     * playing and sleeps otherwise. It runs at the idle priority, on the CPU
+     * time that the display leaves.
+     */
+    Application *application = (Application *)pvParameters;
+    Ring *ring = application->ring;
+    u32 t = 0;
+
+    while (true) {
+        AnimationIdx animationIdx = application->animationIdx;
+        if (animationIdx >= application->animationsNb ||
+                !application->animations[animationIdx].isGenerated) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        /* The ring is full, the panels are behind. */
+        Ring::Slot *slot = ring->acquire();
+        if (slot == 0) {
+            vTaskDelay(1);
+            continue;
+        }
+
+        drawRipples(slot->frame, t++);
+        slot->delay = GENERATED_FRAME_DELAY_MS;
+        ring->publish();
+    }
+}
+
+static void
+printRingStats(Application *application)
+{
+    Ring::Stats stats = application->ring->getStats();
+    if (stats.publishedNb == 0)
+        return;
+
+    xil_printf(
+        "Generated: %d frames, %d presented, %d dropped, %d times full, "
+            "at most %d queued" EOL,
+        (int)stats.publishedNb,
+        (int)stats.takenNb,
+        (int)stats.droppedNb,
+        (int)stats.rejectedNb,
+        (int)stats.maxQueuedNb
+    );
+}
+
+static int
+decodeFrame(Application *application)
+{
+    /*
+     * Decode the next frame of the current animation over the last one, and
+     * return how long it stays [ms], 0 for scrolling content, which stays.
+     */
     Animation *animation = &application->animations[application->animationIdx];
-    Frames *frames = animation->frames;
-    size_t framesNb = animation->framesNb;
-    size_t frameIdx = application->frameIdx;
 
-    display->send(Ssd1306::ColumnAddress, 0, 127);
-    display->send(Ssd1306::PageAddress, 0, 3);
-    display->send(frames[frameIdx].buffer, NELS(frames[0].buffer));
+    /* The render tasks are done with the last generated frame. */
+    if (application->takenSlot) {
+        application->ring->release();
+        application->takenSlot = 0;
+    }
 
-    /* Schedule displaying of the next frame after the delay time. */
-    int delay = frames[frameIdx].delay;
+    application->frameScroll = animation->scroll;
+    application->frame = application->decodedFrame;
+    if (animation->scroll) {
+        animation->decoder.rewind();
+        animation->decoder.decode(application->decodedFrame);
+        return 0;
+    }
+
+    int delay;
+    if (animation->isGenerated) {
+        /* The frame is presented right out of the ring, no copy made. */
+        while ((application->takenSlot = application->ring->take()) == 0)
+            vTaskDelay(1);
+        application->frame = application->takenSlot->frame;
+        delay = application->takenSlot->delay;
+    }
+    else {
+        delay = animation->decoder.decode(application->decodedFrame);
+    }
     if (delay < portTICK_PERIOD_MS)
-        delay = portTICK_PERIOD_MS; /* Timers assert on 0. */
+        delay = portTICK_PERIOD_MS; /* A tick at least, the pace goes in ticks. */
+    return delay;
+}
 
-    xTimerChangePeriod(
-        application->animationTimer,
-        delay / portTICK_PERIOD_MS,
-        100
-    );
+static void
+showFrame(Application *application)
+{
+    /* Hand the decoded frame to the render tasks, they render it in parallel. */
+    EventBits_t doneBits = application->getDoneBits();
 
-    /* Calculate the next frame to show. */
-    ++frameIdx;
-    if (frameIdx == framesNb)
-        frameIdx = 0;
-    application->frameIdx = frameIdx;
+#if SHOULD_TRACE_FRAMES
+    XTime startTime;
+    XTime_GetTime(&startTime);
+    traceFrame(application, startTime);
+#endif
+
+    xEventGroupClearBits(application->panelEvents, doneBits);
+    for (size_t i = 0; i < application->panelsNb; ++i)
+        xTaskNotifyGive(application->panels[i].renderTask);
+    ++application->shownFramesNb;
+}
+
+static inline TickType_t
+getFrameTick(TickType_t startTick, u32 frameMs)
+{
+    /* The tick a frame due frameMs after startTick is shown at. */
+    return startTick + frameMs / portTICK_PERIOD_MS;
+}
+
+static inline bool
+isTickPast(TickType_t tick)
+{
+    /* Whether tick is gone already, the tick count wraps around. */
+    return (TickType_t)(xTaskGetTickCount() - tick - 1) < portMAX_DELAY / 2;
 }
 
 static void
 playAnimationFn(void *pvParameters)
 {
     Application *application = (Application *)pvParameters;
+    EventBits_t doneBits = application->getDoneBits();
+
+    /*
+     * The frames are due at absolute times, in milliseconds from startTick,
+     * so neither the time it takes to show them nor rounding their delays to
+     * ticks adds up from frame to frame.
+     */
+    bool isPlaying = false;
+        /* Whether there is a frame to show next. */
+    TickType_t startTick = 0;
+    u32 frameMs = 0;
+        /* When the last frame was due. */
+    int frameDelay = 0;
+        /* How long it stays, 0 when there was none. */
+#if SHOULD_TRACE_FRAMES
+    XTime startTime = 0;
+        /* The time of startTick. */
+#endif
 
     while(true)
     {
         AnimationIdx animation_idx;
 
-        /* Block to wait for data arriving on the queue. */
+        /*
+         * Block to wait for data arriving on the queue, unless there is
+         * a frame to show.
+         */
         BaseType_t bt = xQueueReceive(
             application->queue,   /* The queue being read. */
             &animation_idx,       /* Data is read into this address. */
-            100 /* Nb. of ticks to block for if the menu_id is not immediately available.*/
+            isPlaying ? 0 : portMAX_DELAY
         );
 
         /*
@@ -141,32 +1047,80 @@ playAnimationFn(void *pvParameters)
          * one.
          */
         if (bt && animation_idx != application->animationIdx) {
-            if (animation_idx > application->animationsNb) {
+            if (animation_idx >= application->animationsNb) {
                 print("But I can't show you that..." EOL);
             }
             else {
-                if(xTimerIsTimerActive(application->animationTimer)) {
-                    /* Ensure the timer is not in the active state. */
-                    xTimerStop(application->animationTimer, 100);
-                }
-
                 /* Select new animation for playing. */
                 application->animationIdx = animation_idx;
-                application->frameIdx = 0;
-
-                /*
-                 * The timer is in dormant state - change its period to 1 tick.
-                 * This *will* activate the timer. Block for a maximum of 100
-                 * ticks if the change period command cannot immediately be sent
-                 * to the timer command queue.
-                 */
-                xTimerChangePeriod(
-                    application->animationTimer,
-                    1, /* Timers assert on 0. */
-                    100
-                );
+                application->animations[animation_idx].decoder.rewind();
+                if (application->animations[animation_idx].isGenerated)
+                    xTaskNotifyGive(application->generateTask);
+
+                /* Start right on a tick, the frames are shown on ticks. */
+                vTaskDelay(1);
+                startTick = xTaskGetTickCount();
+#if SHOULD_TRACE_FRAMES
+                XTime_GetTime(&startTime);
+#endif
+                frameMs = 0;
+                frameDelay = 0;
+                isPlaying = true;
             }
         }
+
+        if (!isPlaying)
+            continue;
+
+        /* The panels have to be done with the last frame to decode over it. */
+        xEventGroupWaitBits(
+            application->panelEvents,
+            doneBits,
+            pdFALSE,            /* The bits are cleared by showFrame(). */
+            pdTRUE,             /* All of them. */
+            portMAX_DELAY
+        );
+        int delay = decodeFrame(application);
+
+#if FRAME_OVERRUN_POLICY == OVERRUN_DROP
+        /* Skip the frames that would be over by the time they are shown. */
+        while (frameDelay > 0 && delay > 0 &&
+                isTickPast(getFrameTick(startTick, frameMs + frameDelay + delay))) {
+            frameMs += frameDelay;
+            frameDelay = delay;
+            delay = decodeFrame(application);
+            ++application->droppedFramesNb;
+        }
+#elif FRAME_OVERRUN_POLICY == OVERRUN_SLIP
+        /* Start over from now rather than rush the late frames through. */
+        if (frameDelay > 0 && isTickPast(getFrameTick(startTick, frameMs + frameDelay))) {
+            startTick = xTaskGetTickCount();
+#if SHOULD_TRACE_FRAMES
+            XTime_GetTime(&startTime);
+#endif
+            frameMs = 0;
+            frameDelay = 0;
+        }
+#endif
+
+        /* With OVERRUN_CATCH_UP, late frames do not wait here at all. */
+        if (frameDelay > 0) {
+            TickType_t wakeTick = getFrameTick(startTick, frameMs);
+            frameMs += frameDelay;
+            vTaskDelayUntil(&wakeTick, getFrameTick(startTick, frameMs) - wakeTick);
+        }
+
+#if SHOULD_TRACE_FRAMES
+        application->frameDueTime =
+            startTime + (XTime)frameMs * (COUNTS_PER_SECOND / 1000);
+#endif
+        xSemaphoreTake(application->panelsMutex, portMAX_DELAY);
+        showFrame(application);
+        xSemaphoreGive(application->panelsMutex);
+
+        /* Scrolling content has a single frame, the controllers do the rest. */
+        frameDelay = delay;
+        isPlaying = delay > 0;
     }
 }
 
@@ -175,31 +1129,71 @@ showMenuFn(void *pvParameters) {
 
     Application *application = (Application *)pvParameters;
 
+    if (SHOULD_CALIBRATE_SCLK) {
+        for (size_t i = 0; i < application->panelsNb; ++i)
+            calibrateSclk(&application->panels[i]);
+    }
+
     while(true)
     {
         print(ED CUP);
+        printIdleShare();
+
+        /*
+         * The counts of the drivers and the registers of the IPs are read
+         * with the render tasks off the panels, a frame is held up for it.
+         */
+        lockPanels(application);
+        for (size_t i = 0; i < application->panelsNb; ++i) {
+            printMmioPerFrame(&application->panels[i]);
+            printPerfCounters(&application->panels[i]);
+        }
+        unlockPanels(application);
+        printRingStats(application);
         print("Hi There, your options are:" EOL);
         print(EOL);
         print("1) Don't Blink, or" EOL);
         print("2) Behind the Mirror, or" EOL);
         print("3) The Swarm, or" EOL);
         print("4) Eyes Wide Shut, or" EOL);
-        print("5) I don't want to play this game anymore." EOL);
+        print("5) Round and Round, or" EOL);
+        print("6) Making Waves, or" EOL);
+        print("7) I don't want to play this game anymore." EOL);
+#if SHOULD_TRACE_FRAMES
+        print("8) How did the frames go?" EOL);
+#endif
+        print("9) Lights out, or back on." EOL);
         print(EOL);
         print("You choose?" EOL);
 
         char8 ib = inbyte();
-        if (ib < '1' || ib > '5') {
+#if SHOULD_TRACE_FRAMES
+        if (ib == '8') {
+            printFrameTrace(application);
+            print("Press any key to have another go.");
+            inbyte();
+            continue;
+        }
+#endif
+        if (ib == '9') {
+            toggleSleep(application);
+            print("Press any key to have another go.");
+            inbyte();
+            continue;
+        }
+        if (ib < '1' || ib > '7') {
             print("You chose poorly..." EOL);
         }
         else {
             xil_printf("You've chosen: %c." EOL, ib);
-            if (ib == '5') {
+            if (ib == '7') {
                 print("Sorry to see you going. Bye, bye..." EOL);
                 break;
             }
 
-            application->display->send(Ssd1306::EntireDisplayResume);
+            lockPanels(application);
+            sendToPanels(application, Display::EntireDisplayResume);
+            unlockPanels(application);
 
             AnimationIdx animationIdx = ib - '0' - 1;
 
@@ -219,10 +1213,16 @@ showMenuFn(void *pvParameters) {
         inbyte();
     }
 
-    /* Cleanup the allocated resources. */
-    application->display->powerOff();
-    xTimerDelete(application->animationTimer, portMAX_DELAY);
+    /* Cleanup the allocated resources, none of them in use. */
+    lockPanels(application);
     vTaskDelete(application->playAnimationTask);
+    vTaskDelete(application->generateTask);
+    for (size_t i = 0; i < application->panelsNb; ++i) {
+        vTaskDelete(application->panels[i].renderTask);
+        application->panels[i].display.powerOff();
+    }
+    vEventGroupDelete(application->panelEvents);
+    vSemaphoreDelete(application->panelsMutex);
     vTaskDelete(application->showMenuTask);
     vQueueDelete(application->queue);
 }
@@ -230,24 +1230,64 @@ showMenuFn(void *pvParameters) {
 int
 main(void) {
 
+#if SHOULD_READ_ANIMATIONS_FROM_FLASH
+    MemoryStorage storages[] = {
+        getFlashSlot(0),
+        getFlashSlot(1),
+        getFlashSlot(2),
+        getFlashSlot(3),
+    };
+#else
+    MemoryStorage storages[] = {
+        MemoryStorage(container1, sizeof(container1)),
+        MemoryStorage(container2, sizeof(container2)),
+        MemoryStorage(container3, sizeof(container3)),
+        MemoryStorage(container4, sizeof(container4)),
+    };
+#endif
+
     static
     Animation animations[] = {
-        { frames1, NELS(frames1) },
-        { frames2, NELS(frames2) },
-        { frames3, NELS(frames3) },
-        { frames4, NELS(frames4) },
+        Animation(storages[0]),
+        Animation(storages[1]),
+        Animation(storages[2]),
+        Animation(storages[3]),
+        Animation(storages[0], &marquee),
+        Animation(MemoryStorage(), 0, true),
     };
 
     static
-    Ssd1306 display;
+    Ring ring(SHOULD_OVERWRITE_OLDEST ? Ring::OverwriteOldest : Ring::Backpressure);
+
+    configASSERT(NELS(panelConfigs) <= PANELS_MAX);
+
+    static
+    Panel panels[NELS(panelConfigs)];
 
     static
     Application application(
         animations,
         NELS(animations),
-        &display
+        panels,
+        NELS(panels)
     );
 
+    for (size_t i = 0; i < NELS(panels); ++i) {
+        Panel *panel = &panels[i];
+        panel->application = &application;
+        panel->index = i;
+        panel->irqId = panelConfigs[i].irqId;
+        panel->display = Display(RuntimeMmioBus(panelConfigs[i].baseAddress));
+        panel->presenter.setDoubleBuffered(SHOULD_DOUBLE_BUFFER);
+    }
+
+    /* The panels start out done with the frame before the first one. */
+    application.panelEvents = xEventGroupCreate();
+    configASSERT(application.panelEvents);
+    xEventGroupSetBits(application.panelEvents, application.getDoneBits());
+    application.panelsMutex = xSemaphoreCreateMutex();
+    configASSERT(application.panelsMutex);
+
     /* Create the queue used for communication between the tasks. */
     application.queue = 
         xQueueCreate(
@@ -258,6 +1298,8 @@ main(void) {
     /* Check the queue was created. */
     configASSERT(application.queue);
 
+    application.ring = &ring;
+
     /* 
      * Create the two tasks.
      *
@@ -277,8 +1319,9 @@ main(void) {
     /*
      * The PlayAnimation task has a higher priority than the ShowMenu task, so
      * will preempt the ShowMenu task and remove values from the queue as soon
-     * as the ShowMenu task writes to the queue - therefore the queue can never
-     * have more than one item in it.
+     * as the ShowMenu task writes to the queue, or with the next frame while
+     * it paces one - the menu waits for a key in between, so the queue never
+     * has more than one item in it.
      */
     xTaskCreate(
         playAnimationFn,
@@ -290,27 +1333,43 @@ main(void) {
     );
 
     /*
-     * Create a timer that is going to be used in displaying individual frames.
-     *
-     * The timer is created in the dormant state. We live responsibility of
-     * activating the timer to the PlayAnimation task.
+     * The Generate task shares the idle priority with the ShowMenu task, which
+     * spends its time waiting for keys.
      */
-    application.animationTimer =
-        xTimerCreate(
-            "Timer",        /* The text name that is assigned to the timer. */
-            1,              /* The timer period. Timers assert on 0. */
-            pdFALSE,        /* The flag whether to expire repeatedly after the timer period. */
-            &application,   /* The identifier that is assigned to the timer. */
-            showFrame       /* The function to call when the timer expires. */
-        );
+    xTaskCreate(
+        generateFn,
+        "Generate",
+        configMINIMAL_STACK_SIZE,
+        &application,
+        tskIDLE_PRIORITY,
+        &application.generateTask
+    );
 
-    /* Check the timer was created. */
-    configASSERT(application.animationTimer);
+    /*
+     * A render task per panel, above the PlayAnimation task so a frame handed
+     * over gets rendered right away, all the panels at once while their tasks
+     * sleep on their irqs.
+     */
+    for (size_t i = 0; i < NELS(panels); ++i) {
+        xTaskCreate(
+            renderFn,
+            "Render",
+            RENDER_TASK_STACK_SIZE,
+            &panels[i],
+            tskIDLE_PRIORITY + 2,
+            &panels[i].renderTask
+        );
+    }
 
-    /* Turn the OLED display on. */
-    display.powerOn();
+    /* Turn the OLED displays on. */
+    for (size_t i = 0; i < NELS(panels); ++i) {
+        panels[i].display.setStreaming(SHOULD_STREAM_SPI);
+        panels[i].display.powerOn();
+        if (SHOULD_FADE_ON_SLEEP)
+            loadFadeScripts(&panels[i].display);
+    }
     sleep(1);
-    display.send(Ssd1306::EntireDisplayOn);
+    sendToPanels(&application, Display::EntireDisplayOn);
 
     /* Start the tasks running. */
     vTaskStartScheduler();
@@ -0,0 +1,425 @@
+/************************************************
+ framepack.c
+
+ Packs the frames of a -u32.inc file, as produced
+ by gif2xbm.sh, into the format read by
+ FrameDecoder (ps/include/FrameDecoder.hpp):
+
+   gcc -O2 -o framepack framepack.c
+   ./framepack 380r-u32.inc 380r-packed.inc
+
+ Every frame is a 3-byte header followed by
+ tokens that produce its 128 words in order:
+
+   header: flags (bit 0: intra frame,
+                  bit 1: reference frame),
+           delay [ms] as u16, little endian
+   token:  00nnnnnn - skip n+1 words
+           01nnnnnn - n+1 copies of the word
+                      that follows
+           10nnnnnn - the n+1 words that follow
+
+ Skipped words keep the value of the previous
+ frame, or 0 in an intra frame. Words are stored
+ little endian. The first frame is always intra,
+ the others are whichever of intra and delta is
+ shorter.
+
+ Identical frames are found by their hashes and
+ compared. Consecutive ones are merged into one
+ frame with the sum of their delays. Repeats that
+ are not adjacent become reference frames, which
+ instead of tokens carry the offset (u24, little
+ endian) of the header of the first occurrence,
+ which is then encoded as an intra frame. Either
+ is done only where it makes the output shorter.
+
+ With -c the output is a container, as read by
+ FrameStream (ps/include/FrameStream.hpp), which
+ indexes the frames, so they can be fetched one
+ at a time from flash or a file:
+
+   ./framepack -c 380r-u32.inc 380r.anim
+   ./framepack -c 380r-u32.inc 380r-anim.inc
+
+ A .inc output holds it as an initializer, any
+ other the bytes as they are.
+ ************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define WORDS_NB 128
+#define TOKEN_NB_MAX 64
+#define OP_SKIP 0x00
+#define OP_RUN 0x40
+#define OP_LITERAL 0x80
+#define IS_INTRA 0x01
+#define IS_REFERENCE 0x02
+#define HEADER_NB 3
+#define REFERENCE_NB (HEADER_NB + 3)
+#define DELAY_MAX 0xFFFF
+#define CONTAINER_MAGIC "OLAN"
+#define CONTAINER_VERSION 1
+#define CONTAINER_HEADER_NB 20
+#define CONTAINER_ENTRY_NB 8
+#define ENCODED_NB_MAX (WORDS_NB * 4 + WORDS_NB / TOKEN_NB_MAX)
+#define EOL "\n"
+
+struct frame {
+    unsigned int words[WORDS_NB];
+    int delay;
+};
+
+/* Read all numbers of the initializer, skipping comments and declarations. */
+static int readFrames(const char *filename, struct frame **frames) {
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL)
+        return -1;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *text = malloc(size + 1);
+    if (fread(text, 1, size, fp) != (size_t)size) {
+        fclose(fp);
+        free(text);
+        return -1;
+    }
+    text[size] = '\0';
+    fclose(fp);
+
+    /* Blank the comments out. */
+    for (char *c = strstr(text, "//"); c != NULL; c = strstr(c, "//"))
+        while (*c != '\0' && *c != '\n')
+            *c++ = ' ';
+
+    /* The initializer starts after '=', if there is a declaration. */
+    char *c = strchr(text, '=');
+    c = c != NULL ? c + 1 : text;
+
+    int framesNb = 0, capacity = 0, wordIdx = 0;
+    *frames = NULL;
+    while (*c != '\0') {
+        if (!isdigit((unsigned char)*c)) {
+            ++c;
+            continue;
+        }
+
+        char *end;
+        unsigned long value = strtoul(c, &end, 0);
+        c = end;
+
+        if (wordIdx == 0 && framesNb == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            *frames = realloc(*frames, capacity * sizeof(**frames));
+        }
+        if (wordIdx < WORDS_NB) {
+            (*frames)[framesNb].words[wordIdx++] = value;
+        }
+        else {
+            (*frames)[framesNb++].delay = value;
+            wordIdx = 0;
+        }
+    }
+
+    free(text);
+    return wordIdx == 0 ? framesNb : -1;
+}
+
+static int putWord(unsigned char *out, unsigned int word) {
+    out[0] = word;
+    out[1] = word >> 8;
+    out[2] = word >> 16;
+    out[3] = word >> 24;
+    return 4;
+}
+
+/* Encode words against base, return the number of bytes written to out. */
+static int encode(const unsigned int *words, const unsigned int *base, unsigned char *out) {
+    int n = 0, i = 0;
+    while (i < WORDS_NB) {
+        int j = i;
+
+        /* Words that are there already. */
+        while (j < WORDS_NB && j - i < TOKEN_NB_MAX && words[j] == base[j])
+            ++j;
+        if (j > i) {
+            out[n++] = OP_SKIP | (j - i - 1);
+            i = j;
+            continue;
+        }
+
+        /* A run pays off from 2 words on. */
+        while (j < WORDS_NB && j - i < TOKEN_NB_MAX && words[j] == words[i])
+            ++j;
+        if (j - i >= 2) {
+            out[n++] = OP_RUN | (j - i - 1);
+            n += putWord(&out[n], words[i]);
+            i = j;
+            continue;
+        }
+
+        /* Literal words up to the next skip or run. */
+        j = i + 1;
+        while (j < WORDS_NB && j - i < TOKEN_NB_MAX && words[j] != base[j] &&
+                !(j + 1 < WORDS_NB && words[j + 1] == words[j]))
+            ++j;
+        out[n++] = OP_LITERAL | (j - i - 1);
+        for (; i < j; ++i)
+            n += putWord(&out[n], words[i]);
+    }
+    return n;
+}
+
+static int writeInc(const char *filename, const char *name, int framesNb, const unsigned char *data, int size) {
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL)
+        return -1;
+
+    fprintf(fp, "// %s: %d frames, %d bytes packed"EOL, name, framesNb, size);
+    fprintf(fp, "{"EOL);
+    for (int i = 0; i < size; ++i)
+        fprintf(fp, "0x%02x,%s", data[i], (i % 16 == 15 || i == size - 1) ? EOL : " ");
+    fprintf(fp, "};"EOL);
+    fclose(fp);
+    return 0;
+}
+
+static void putU16(unsigned char *p, unsigned int value) {
+    p[0] = value;
+    p[1] = value >> 8;
+}
+
+static void putU32(unsigned char *p, unsigned int value) {
+    putU16(p, value);
+    putU16(p + 2, value >> 16);
+}
+
+/*
+ * Wrap the size bytes of packed frames at data into a container: the header,
+ * an index entry per frame and the packed frames as they are. Return the
+ * container, of *containerSize bytes, to be freed.
+ */
+static unsigned char *makeContainer(const struct frame *frames, int framesNb, const int *frameOffsets,
+        const unsigned char *data, int size, int *containerSize) {
+    int indexOffset = CONTAINER_HEADER_NB;
+    int payloadsOffset = indexOffset + framesNb * CONTAINER_ENTRY_NB;
+    unsigned char *container = malloc(payloadsOffset + size);
+
+    memcpy(container, CONTAINER_MAGIC, 4);
+    putU16(&container[4], CONTAINER_VERSION);
+    putU16(&container[6], framesNb);
+    putU32(&container[8], indexOffset);
+    putU32(&container[12], payloadsOffset);
+    putU32(&container[16], size);
+
+    for (int f = 0; f < framesNb; ++f) {
+        unsigned char *entry = &container[indexOffset + f * CONTAINER_ENTRY_NB];
+        int end = f + 1 < framesNb ? frameOffsets[f + 1] : size;
+        putU32(&entry[0], frameOffsets[f]);
+        putU16(&entry[4], end - frameOffsets[f]);
+        putU16(&entry[6], frames[f].delay);
+    }
+
+    memcpy(&container[payloadsOffset], data, size);
+    *containerSize = payloadsOffset + size;
+    return container;
+}
+
+static int writeBin(const char *filename, const unsigned char *data, int size) {
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL)
+        return -1;
+
+    int rc = fwrite(data, 1, size, fp) == (size_t)size ? 0 : -1;
+    if (fclose(fp) != 0)
+        rc = -1;
+    return rc;
+}
+
+static int isIncFile(const char *filename) {
+    size_t length = strlen(filename);
+    return length >= 4 && strcmp(filename + length - 4, ".inc") == 0;
+}
+
+/* FNV-1a over the words of a frame. */
+static unsigned int hashFrame(const struct frame *f) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < WORDS_NB; ++i)
+        for (int b = 0; b < 32; b += 8) {
+            hash ^= (f->words[i] >> b) & 0xFF;
+            hash *= 16777619u;
+        }
+    return hash;
+}
+
+/* Merge the consecutive identical frames, return the new number of frames. */
+static int mergeFrames(struct frame *frames, int framesNb) {
+    int n = 0;
+    for (int f = 0; f < framesNb; ++f) {
+        if (n > 0 &&
+                memcmp(frames[n - 1].words, frames[f].words, sizeof(frames[f].words)) == 0 &&
+                frames[n - 1].delay + frames[f].delay <= DELAY_MAX) {
+            frames[n - 1].delay += frames[f].delay;
+            continue;
+        }
+        frames[n++] = frames[f];
+    }
+    return n;
+}
+
+/*
+ * Pack frames into data, return the number of bytes written. With shouldDedup
+ * the repeated frames are stored as references where that is shorter, the
+ * number of them goes to referencesNb. The offset of every frame in data goes
+ * to frameOffsets, unless that is NULL.
+ */
+static int pack(const struct frame *frames, int framesNb, int shouldDedup, unsigned char *data, int *referencesNb,
+        int *frameOffsets) {
+    static const unsigned int zeros[WORDS_NB];
+    unsigned char out[ENCODED_NB_MAX];
+    int *intraNbs = malloc(framesNb * sizeof(int));
+    int *deltaNbs = malloc(framesNb * sizeof(int));
+    int *firsts = malloc(framesNb * sizeof(int));
+    int *offsets = malloc(framesNb * sizeof(int));
+    int *isIntras = malloc(framesNb * sizeof(int));
+    unsigned int *hashes = malloc(framesNb * sizeof(unsigned int));
+
+    for (int f = 0; f < framesNb; ++f) {
+        intraNbs[f] = encode(frames[f].words, zeros, out);
+        deltaNbs[f] = f > 0 ? encode(frames[f].words, frames[f - 1].words, out) : ENCODED_NB_MAX + 1;
+        isIntras[f] = intraNbs[f] <= deltaNbs[f];
+        hashes[f] = hashFrame(&frames[f]);
+
+        /* The first occurrence of the same frame, if any. */
+        firsts[f] = -1;
+        for (int g = 0; shouldDedup && g < f - 1; ++g) {
+            if (hashes[g] == hashes[f] && firsts[g] < 0 &&
+                    memcmp(frames[g].words, frames[f].words, sizeof(frames[f].words)) == 0) {
+                firsts[f] = g;
+                break;
+            }
+        }
+    }
+
+    /*
+     * A first occurrence that is a delta frame pays for becoming intra only
+     * if its repeats save more than that.
+     */
+    for (int g = 0; g < framesNb; ++g) {
+        if (isIntras[g])
+            continue;
+
+        int savedNb = 0;
+        for (int f = g + 2; f < framesNb; ++f) {
+            int nb = HEADER_NB + (isIntras[f] ? intraNbs[f] : deltaNbs[f]);
+            if (firsts[f] == g && nb > REFERENCE_NB)
+                savedNb += nb - REFERENCE_NB;
+        }
+        if (savedNb > intraNbs[g] - deltaNbs[g])
+            isIntras[g] = 1;
+    }
+
+    int size = 0;
+    *referencesNb = 0;
+    for (int f = 0; f < framesNb; ++f) {
+        int g = firsts[f];
+        int nb = isIntras[f] ? intraNbs[f] : deltaNbs[f];
+        offsets[f] = size;
+        if (frameOffsets != NULL)
+            frameOffsets[f] = size;
+
+        if (g >= 0 && isIntras[g] && HEADER_NB + nb > REFERENCE_NB) {
+            data[size++] = IS_REFERENCE;
+            data[size++] = frames[f].delay;
+            data[size++] = frames[f].delay >> 8;
+            data[size++] = offsets[g];
+            data[size++] = offsets[g] >> 8;
+            data[size++] = offsets[g] >> 16;
+            ++*referencesNb;
+            continue;
+        }
+
+        data[size++] = isIntras[f] ? IS_INTRA : 0;
+        data[size++] = frames[f].delay;
+        data[size++] = frames[f].delay >> 8;
+        if (isIntras[f])
+            size += encode(frames[f].words, zeros, &data[size]);
+        else
+            size += encode(frames[f].words, frames[f - 1].words, &data[size]);
+    }
+
+    free(hashes);
+    free(isIntras);
+    free(offsets);
+    free(firsts);
+    free(deltaNbs);
+    free(intraNbs);
+    return size;
+}
+
+int main(int argc, char *argv[]) {
+    int shouldContain = argc == 4 && strcmp(argv[1], "-c") == 0;
+    if (argc != 3 && !shouldContain) {
+        fprintf(stderr, "Usage: %s [-c] <input -u32.inc file> <output .inc file>"EOL, argv[0]);
+        return 1;
+    }
+    const char *inputName = argv[argc - 2];
+    const char *outputName = argv[argc - 1];
+
+    struct frame *frames;
+    int framesNb = readFrames(inputName, &frames);
+    if (framesNb <= 0) {
+        fprintf(stderr, "%s: no frames or a truncated frame."EOL, inputName);
+        return 1;
+    }
+
+    /* The worst case is a literal token per 64 words, plus the header. */
+    unsigned char *data = malloc(framesNb * (HEADER_NB + ENCODED_NB_MAX));
+    int referencesNb;
+    int plainSize = pack(frames, framesNb, 0, data, &referencesNb, NULL);
+    int rawSize = framesNb * (WORDS_NB * 4 + (int)sizeof(int));
+    int rawFramesNb = framesNb;
+
+    framesNb = mergeFrames(frames, framesNb);
+    int *frameOffsets = malloc(framesNb * sizeof(int));
+    int size = pack(frames, framesNb, 1, data, &referencesNb, frameOffsets);
+
+    char name[256];
+    const char *base = strrchr(inputName, '/');
+    snprintf(name, sizeof(name), "%s", base != NULL ? base + 1 : inputName);
+    char *suffix = strstr(name, "-u32.inc");
+    if (suffix != NULL)
+        *suffix = '\0';
+
+    int rc;
+    if (shouldContain) {
+        int containerSize;
+        unsigned char *container = makeContainer(frames, framesNb, frameOffsets, data, size, &containerSize);
+        if (isIncFile(outputName))
+            rc = writeInc(outputName, name, framesNb, container, containerSize);
+        else
+            rc = writeBin(outputName, container, containerSize);
+        free(container);
+    }
+    else {
+        rc = writeInc(outputName, name, framesNb, data, size);
+    }
+    if (rc != 0) {
+        fprintf(stderr, "%s: cannot write."EOL, outputName);
+        return 1;
+    }
+
+    printf("%s: %d frames, %d -> %d bytes (%d%%)"EOL,
+        name, rawFramesNb, rawSize, size, 100 * size / rawSize);
+    printf("%s: %d frames merged, %d references, %d bytes saved"EOL,
+        name, rawFramesNb - framesNb, referencesNb, plainSize - size);
+
+    free(frameOffsets);
+    free(data);
+    free(frames);
+    return 0;
+}
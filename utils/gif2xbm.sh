@@ -1,13 +1,14 @@
 #! /bin/sh
 
-if [ "$#" != "4" ]; then
+if [ "$#" -lt "5" ]; then
     echo \
 "The following parameters are required:
 - file name of the input .gif file (with extension),
 - number specifying format of data in the output file (32 or 8),
 - color of background (white or black),
 - invertion of colours flag (1 or 0), and
-- full pathname to xbm2bin.c"
+- full pathname to xbm2inc.cpp, and optionally
+- full pathname to framepack.c (packs the output of format 32)"
     exit 1
 fi
 
@@ -15,11 +16,12 @@ ifn=$1 # file name of the input .gif file (with extension)
 dt=$2 # number specifying format of data in the output file (32 or 8)
 bkgd=$3 # color of background (white or black)
 invf=$4 # invertion of colours flag (1 or 0)"
-xbm2bin=$5 # full pathname to xbm2bin.c (it is stored under utils/ of this repo)
+xbm2inc=$5 # full pathname to xbm2inc.cpp (it is stored under utils/ of this repo)
+framepack=$6 # full pathname to framepack.c (it is stored under utils/ of this repo)
 
 ofn=`basename $1 .gif`
-if [ ! -f $xbm2bin ]; then
-    echo "$xbm2bin does not exist."
+if [ ! -f $xbm2inc ]; then
+    echo "$xbm2inc does not exist."
     exit 1
 fi
 
@@ -33,35 +35,18 @@ for fn in `ls -tr *.xbm`; do
     rm $fn
 done
 
-pushd 128x32/
-for fn in `ls -tr *.xbm`; do 
-    bn=`basename $fn .xbm`
-    sed -i "s/$bn/line/" $fn
-    cp $fn line.inc
-    gcc \
-        -w \
-        -I. \
-        -DXBM2BIN_U$dt -DXBM2BIN_INVERT=$invf \
-        -o xbm2bin \
-        $xbm2bin
-    ./xbm2bin
-    rm xbm2bin line.inc
-    echo "// $bn" >$bn.bin
-    cat line_bits.bin >>$bn.bin
-    rm line_bits.bin
-done
-
-oinc="../$ofn-u$dt.inc"
-#echo "static u$dt buffer[][$((32 / $dt)) * 128] = {" > $oinc
-echo "static struct frames {u$dt buffer[$((32 / $dt))*128]; int delay;} frames[] = {" >$oinc
+g++ -std=c++11 -O2 -pthread -o xbm2inc $xbm2inc
+frames=()
 i=0
-for fn in `ls -tr *.bin`; do 
-    echo "{" >>$oinc
-    cat $fn >>$oinc
-    echo "${delays[$((i++))]}0" >>$oinc
-    echo "}," >>$oinc
+for fn in `ls -tr 128x32/*.xbm`; do
+    frames+=($fn "${delays[$((i++))]}0")
 done
-echo "};" >>$oinc
-popd
+./xbm2inc $dt $invf $ofn-u$dt.inc "${frames[@]}"
+rm xbm2inc
 rm -rf 128x32/
 
+if [ -n "$framepack" -a "$dt" = "32" ]; then
+    gcc -O2 -o framepack $framepack
+    ./framepack $ofn-u32.inc $ofn-packed.inc
+    rm framepack
+fi
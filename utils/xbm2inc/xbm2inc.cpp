@@ -0,0 +1,295 @@
+/************************************************
+ xbm2inc.cpp
+
+ Converts all frames of an animation, 128x32
+ XBM (or PBM) files, into the .inc file that
+ gif2xbm.sh used to put together by compiling
+ and running xbm2bin.c for every frame. The
+ output is byte-identical to that of xbm2bin.c.
+
+   g++ -std=c++11 -O2 -pthread -o xbm2inc xbm2inc.cpp
+   ./xbm2inc 32 0 380r-u32.inc \
+       380r.gif-0.xbm.128x32.xbm 2000 ...
+
+ The arguments are: the format of the data (32
+ or 8), the invertion of colours flag (1 or 0),
+ the output file and then pairs of a frame file
+ and its delay, written out as given.
+
+ The frames are read and converted in parallel,
+ a thread per core. Every 8 rows by 8 columns of
+ pixels are turned into the 8 bytes of a page
+ with a single 8x8 bit transpose.
+ ************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define WIDTH 128
+#define HEIGHT 32
+#define BYTE_LENGTH 8
+#define ROW_BYTES (WIDTH / BYTE_LENGTH)
+#define EOL "\n"
+
+struct Frame {
+    const char *filename;
+    const char *delay;
+    uint8_t bits[HEIGHT * ROW_BYTES];
+        /* Rows top to bottom, bit 0 of a byte is its leftmost pixel. */
+    std::string text;
+    std::string error;
+};
+
+static bool readFile(const char *filename, std::string &content) {
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL)
+        return false;
+
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        content.append(buffer, n);
+    fclose(fp);
+    return true;
+}
+
+/* The value of a #define whose name ends with suffix, or -1. */
+static long xbmDefine(const std::string &content, const char *suffix) {
+    for (size_t at = content.find("#define"); at != std::string::npos; at = content.find("#define", at + 1)) {
+        size_t eol = content.find('\n', at);
+        std::string line = content.substr(at, eol == std::string::npos ? std::string::npos : eol - at);
+        char name[256];
+        long value;
+        if (sscanf(line.c_str(), "#define %255s %li", name, &value) == 2) {
+            size_t n = strlen(name), m = strlen(suffix);
+            if (n >= m && strcmp(name + n - m, suffix) == 0)
+                return value;
+        }
+    }
+    return -1;
+}
+
+static bool parseXbm(const std::string &content, Frame *frame) {
+    if (xbmDefine(content, "_width") != WIDTH || xbmDefine(content, "_height") != HEIGHT) {
+        frame->error = "not a 128x32 XBM";
+        return false;
+    }
+
+    /* X10 files hold shorts, which come as the same bytes on little endian. */
+    bool isX10 = content.find("short") != std::string::npos;
+    size_t at = content.find('{');
+    if (at == std::string::npos) {
+        frame->error = "no bits";
+        return false;
+    }
+
+    const char *c = content.c_str() + at + 1;
+    size_t n = 0;
+    while (n < sizeof(frame->bits)) {
+        char *end;
+        unsigned long value = strtoul(c, &end, 0);
+        if (end == c) {
+            if (*c == '\0' || *c == '}')
+                break;
+            ++c;
+            continue;
+        }
+        c = end;
+        frame->bits[n++] = value;
+        if (isX10 && n < sizeof(frame->bits))
+            frame->bits[n++] = value >> 8;
+    }
+    if (n != sizeof(frame->bits)) {
+        frame->error = "too few bits";
+        return false;
+    }
+    return true;
+}
+
+static bool parsePbm(const std::string &content, Frame *frame) {
+    /* The header: magic, width and height, with comments in between. */
+    const char *c = content.c_str() + 2;
+    const char *end = content.c_str() + content.size();
+    long header[2];
+    for (int i = 0; i < 2; ++i) {
+        while (c < end && (isspace((unsigned char)*c) || *c == '#')) {
+            if (*c == '#')
+                while (c < end && *c != '\n')
+                    ++c;
+            else
+                ++c;
+        }
+        header[i] = strtol(c, (char **)&c, 10);
+    }
+    if (header[0] != WIDTH || header[1] != HEIGHT) {
+        frame->error = "not a 128x32 PBM";
+        return false;
+    }
+
+    memset(frame->bits, 0, sizeof(frame->bits));
+    if (content[1] == '4') {
+        /* Raw, rows of MSB first bytes after a single whitespace. */
+        ++c;
+        if (end - c < (long)sizeof(frame->bits)) {
+            frame->error = "too few bits";
+            return false;
+        }
+        for (size_t i = 0; i < sizeof(frame->bits); ++i) {
+            uint8_t b = c[i];
+            uint8_t r = 0;
+            for (int k = 0; k < BYTE_LENGTH; ++k)
+                r |= ((b >> k) & 1) << (BYTE_LENGTH - 1 - k);
+            frame->bits[i] = r;
+        }
+    }
+    else {
+        /* Plain, a digit per pixel. */
+        for (int p = 0; p < WIDTH * HEIGHT; ++p) {
+            while (c < end && *c != '0' && *c != '1')
+                ++c;
+            if (c == end) {
+                frame->error = "too few pixels";
+                return false;
+            }
+            if (*c++ == '1')
+                frame->bits[p / BYTE_LENGTH] |= 1 << (p % BYTE_LENGTH);
+        }
+    }
+    return true;
+}
+
+/*
+ * Transpose the 8x8 bit matrix held in x, where bit c of byte r moves to bit r
+ * of byte c.
+ */
+static inline uint64_t transpose8x8(uint64_t x) {
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAull;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+static void convert(Frame *frame, int dataType, bool isInverted) {
+    std::string content;
+    if (!readFile(frame->filename, content)) {
+        frame->error = "cannot read";
+        return;
+    }
+
+    bool isOk;
+    if (content.size() > 2 && content[0] == 'P' && (content[1] == '1' || content[1] == '4'))
+        isOk = parsePbm(content, frame);
+    else
+        isOk = parseXbm(content, frame);
+    if (!isOk)
+        return;
+
+    /* The name of the frame, as gif2xbm.sh used to put it. */
+    std::string name = frame->filename;
+    size_t slash = name.rfind('/');
+    if (slash != std::string::npos)
+        name.erase(0, slash + 1);
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".xbm") == 0)
+        name.erase(name.size() - 4);
+
+    std::string &text = frame->text;
+    char buffer[16];
+    text += "{" EOL;
+    text += "// " + name + EOL;
+    text += "{" EOL;
+    for (int page = 0; page < HEIGHT / BYTE_LENGTH; ++page) {
+        /* Columns go from right to left, as in xbm2bin.c. */
+        uint8_t bytes[WIDTH];
+        for (int group = 0; group < ROW_BYTES; ++group) {
+            uint64_t x = 0;
+            for (int k = 0; k < BYTE_LENGTH; ++k)
+                x |= (uint64_t)frame->bits[(page * BYTE_LENGTH + k) * ROW_BYTES + group] << (BYTE_LENGTH * k);
+            x = transpose8x8(x);
+            if (isInverted)
+                x = ~x;
+            for (int c = 0; c < BYTE_LENGTH; ++c)
+                bytes[WIDTH - 1 - (group * BYTE_LENGTH + c)] = x >> (BYTE_LENGTH * c);
+        }
+
+        for (int j = 0; j < WIDTH; ++j) {
+            if (dataType == 8)
+                snprintf(buffer, sizeof(buffer), "0x%02x, ", bytes[j]);
+            else if (j % 4 == 0)
+                snprintf(buffer, sizeof(buffer), "0x%02x%02x%02x%02x, ", bytes[j], bytes[j + 1], bytes[j + 2], bytes[j + 3]);
+            else
+                continue;
+            text += buffer;
+        }
+        text += EOL;
+    }
+    text += "}," EOL;
+    text += std::string(frame->delay) + EOL;
+    text += "}," EOL;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 6 || (argc - 4) % 2 != 0) {
+        fprintf(stderr,
+            "Usage: %s <32|8> <invert 1|0> <output .inc file> <frame file> <delay> [<frame file> <delay> ...]" EOL,
+            argv[0]);
+        return 1;
+    }
+
+    int dataType = atoi(argv[1]);
+    if (dataType != 8 && dataType != 32) {
+        fprintf(stderr, "%s: the format of data must be 32 or 8." EOL, argv[1]);
+        return 1;
+    }
+    bool isInverted = atoi(argv[2]) == 1;
+
+    std::vector<Frame> frames((argc - 4) / 2);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        frames[i].filename = argv[4 + 2 * i];
+        frames[i].delay = argv[5 + 2 * i];
+    }
+
+    /* Every thread takes the next frame that has not been taken yet. */
+    std::atomic<size_t> next(0);
+    unsigned threadsNb = std::thread::hardware_concurrency();
+    if (threadsNb == 0)
+        threadsNb = 1;
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadsNb; ++t) {
+        threads.push_back(std::thread([&]() {
+            for (size_t i = next++; i < frames.size(); i = next++)
+                convert(&frames[i], dataType, isInverted);
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); ++t)
+        threads[t].join();
+
+    FILE *fp = fopen(argv[3], "w");
+    if (fp == NULL) {
+        fprintf(stderr, "%s: cannot write." EOL, argv[3]);
+        return 1;
+    }
+
+    int rc = 0;
+    fprintf(fp, "static struct frames {u%d buffer[%d*128]; int delay;} frames[] = {" EOL, dataType, 32 / dataType);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (!frames[i].error.empty()) {
+            fprintf(stderr, "%s: %s." EOL, frames[i].filename, frames[i].error.c_str());
+            rc = 1;
+        }
+        fputs(frames[i].text.c_str(), fp);
+    }
+    fprintf(fp, "};" EOL);
+    fclose(fp);
+    return rc;
+}